@@ -10,6 +10,11 @@
  */
 
 #include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for further beacons and pass the same frequency to
+// ECPMovement::addBeacon, e.g. 1530
+#define FREQUENCY ECPSignalDetection::BEACON_FREQUENCY
 
 Dezibot dezibot = Dezibot();
 
@@ -17,8 +22,11 @@ void setup() {
     dezibot.begin();
     delay(500);
 
-    dezibot.infraredLight.front.turnOn();
-    dezibot.display.println("IR turned on");
+    // flash with the frequency the other dezibots filter for, so they can
+    // tell the beacon from other infrared light
+    dezibot.infraredLight.front.sendFrequency(FREQUENCY);
+    dezibot.display.println("IR beacon on");
+    dezibot.display.println(String(FREQUENCY) + " Hz");
 }
 
 void loop() {}
@@ -0,0 +1,45 @@
+/**
+ * @file bearing_calibration.ino
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Test sketch for calibrating the angle of an IR signal
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for a calibration fitting the specific dezibot
+#define MOVEMENT_CALIBRATION 3900
+
+Dezibot dezibot = Dezibot();
+ECPMovement ecpMovement(dezibot, MOVEMENT_CALIBRATION);
+ECPSignalDetection ecpSignalDetection = ECPSignalDetection(dezibot);
+
+void setup() {
+    dezibot.begin();
+    dezibot.display.flipOrientation();
+    delay(100);
+
+    dezibot.display.println("Calibrating...");
+    const bool isCalibrated = ecpMovement.calibrateBearing();
+    dezibot.display.clear();
+    dezibot.display.println(isCalibrated ? "Calibrated" : "Failed");
+    delay(2000);
+}
+
+void loop() {
+    dezibot.display.clear();
+
+    // loads the calibration stored by ecpMovement
+    float signalAngle = ecpSignalDetection.measureSignalBearing();
+    dezibot.display.println("S: " + String(signalAngle, 1));
+
+    float dezibotAngle = ecpSignalDetection.measureDezibotBearing();
+    dezibot.display.println("D: " + String(dezibotAngle, 1));
+
+    delay(500);
+}
@@ -10,6 +10,7 @@
  */
 
 #include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
 
 Dezibot dezibot = Dezibot();
 
@@ -17,8 +18,10 @@ void setup() {
     dezibot.begin();
     delay(10);
 
-    dezibot.infraredLight.front.turnOn();
-    dezibot.display.println("IR turned on");
+    // flash with the frequency the other dezibots filter for, so they can
+    // tell the beacon from other infrared light
+    dezibot.infraredLight.front.sendFrequency(ECPSignalDetection::BEACON_FREQUENCY);
+    dezibot.display.println("IR beacon on");
 }
 
 void loop() {}
@@ -0,0 +1,57 @@
+/**
+ * @file capture.ino
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Example to test a capture between two Dezibots
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for a calibration fitting the specific dezibot
+#define MOVEMENT_CALIBRATION 3900
+
+// flash one dezibot with true (white rook on A1), the other one with false
+// (black rook on A5)
+#define IS_CAPTURING true
+
+#define GROUP_NUMBER 24
+
+Dezibot dezibot = Dezibot();
+ECPMovement ecpMovement(dezibot, MOVEMENT_CALIBRATION);
+ECPRook *rook;
+
+void setup() {
+  dezibot.begin();
+  dezibot.display.flipOrientation();
+
+  rook = new ECPRook(
+    dezibot,
+    ecpMovement,
+    IS_CAPTURING ? ECPChessField{A, 1} : ECPChessField{A, 5},
+    IS_CAPTURING
+  );
+  rook->beginCommunication(GROUP_NUMBER);
+  delay(5000);
+}
+
+void loop() {
+  if (IS_CAPTURING) {
+    const bool hasCaptured = rook->capture({A, 5});
+    dezibot.display.clear();
+    dezibot.display.println(hasCaptured ? "Captured" : "Capture failed");
+    while (true) {
+      delay(1000);
+    }
+  }
+
+  if (rook->handleCapture()) {
+    dezibot.display.clear();
+    dezibot.display.println("Captured, bye");
+  }
+  delay(100);
+}
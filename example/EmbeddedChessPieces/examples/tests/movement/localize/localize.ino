@@ -0,0 +1,49 @@
+/**
+ * @file localize.ino
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Test sketch for localizing the dezibot with two infrared beacons
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for a calibration fitting the specific dezibot
+#define MOVEMENT_CALIBRATION 3900
+
+// frequency of the second dezibot running examples/beacon/beacon.ino
+#define SECOND_BEACON_FREQUENCY 1530
+
+Dezibot dezibot = Dezibot();
+ECPMovement ecpMovement(dezibot, MOVEMENT_CALIBRATION);
+
+void setup() {
+    dezibot.begin();
+    dezibot.display.flipOrientation();
+    delay(100);
+
+    // the first beacon stands beyond row 8, the second one beyond column A
+    ecpMovement.setBeaconPosition(3.5f, 8.5f);
+    ecpMovement.addBeacon(SECOND_BEACON_FREQUENCY, -1.0f, 3.5f);
+}
+
+void loop() {
+    dezibot.display.clear();
+    dezibot.display.println("Localizing...");
+
+    // place the dezibot facing north, the heading is needed to triangulate
+    const bool isLocalized = ecpMovement.localize(true);
+    dezibot.display.clear();
+    if (isLocalized) {
+        const ECPChessField field = ecpMovement.getCurrentField();
+        dezibot.display.println("Field: " + field.toString());
+    } else {
+        dezibot.display.println("Failed");
+    }
+
+    delay(5000);
+}
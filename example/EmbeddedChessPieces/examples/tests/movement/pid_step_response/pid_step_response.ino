@@ -0,0 +1,63 @@
+/**
+ * @file pid_step_response.ino
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Example to record the step responses of the heading controllers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for a calibration fitting the specific dezibot
+#define MOVEMENT_CALIBRATION 3900
+
+Dezibot dezibot = Dezibot();
+ECPMovement ecpMovement(dezibot, MOVEMENT_CALIBRATION);
+
+void setup() {
+  Serial.begin(115200);
+  dezibot.begin();
+  dezibot.display.flipOrientation();
+  delay(1000);
+
+  // print every controller update, use the serial plotter to view the response
+  dezibot.motion.straightController.onUpdate(printSample);
+  ecpMovement.onRotationControllerUpdate(printSample);
+}
+
+void loop() {
+  dezibot.display.println("Moving straight...");
+  Serial.println("# straight");
+  dezibot.motion.move(3000, MOVEMENT_CALIBRATION);
+  delay(5000);
+
+  dezibot.display.println("Turning left...");
+  Serial.println("# rotation");
+  ecpMovement.turnLeft({A, 1}, WEST);
+
+  dezibot.display.println("Sleep 10s");
+  delay(10000);
+  dezibot.display.clear();
+}
+
+/**
+ * @brief Print controller sample as comma separated values.
+ *
+ * @param sample Sample of one controller update
+ */
+void printSample(const PIDSample &sample) {
+  Serial.print("error:");
+  Serial.print(sample.error);
+  Serial.print(",p:");
+  Serial.print(sample.proportional);
+  Serial.print(",i:");
+  Serial.print(sample.integral);
+  Serial.print(",d:");
+  Serial.print(sample.derivative);
+  Serial.print(",output:");
+  Serial.println(sample.output);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file rotate_180.ino
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Example to test turning the Dezibot around in one rotation
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for a calibration fitting the specific dezibot
+#define MOVEMENT_CALIBRATION 3900
+
+Dezibot dezibot = Dezibot();
+ECPMovement ecpMovement(dezibot, MOVEMENT_CALIBRATION);
+
+void setup() {
+  dezibot.begin();
+  dezibot.display.flipOrientation();
+  delay(1000);
+}
+
+void loop() {
+  dezibot.display.println("Turning around...");
+  ecpMovement.turnAround({A, 1}, SOUTH);
+  dezibot.display.println("Done");
+  delay(10000);
+
+  dezibot.display.println("Turning around...");
+  ecpMovement.turnAround({A, 1}, NORTH);
+  dezibot.display.println("Done");
+  
+  dezibot.display.println("Sleep 10s");
+  delay(10000);
+  dezibot.display.clear();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file setup_board.ino
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Example to test collision-free planned moves of multiple Dezibots
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Dezibot.h>
+#include <EmbeddedChessPieces.h>
+
+// change for a calibration fitting the specific dezibot
+#define MOVEMENT_CALIBRATION 3900
+
+// flash one dezibot with true to plan and broadcast the paths, it does not
+// move itself and can stand next to the board
+#define IS_COORDINATOR false
+
+// flash the two rooks with 0 (white rook on A1) and 1 (black rook on A2)
+#define PIECE_NUMBER 0
+
+#define GROUP_NUMBER 24
+
+// duration of one slot, long enough for a turn and a move of one field
+#define SLOT_DURATION 8000
+
+// time from broadcasting the paths to the start of slot 0 in ms
+#define START_DELAY 5000
+
+// the rooks swap their fields, so one of them has to drive around the other
+const ECPMoveRequest requests[] = {
+  { 0, {A, 1}, {A, 2} },
+  { 1, {A, 2}, {A, 1} }
+};
+const size_t requestCount = sizeof(requests) / sizeof(requests[0]);
+
+Dezibot dezibot = Dezibot();
+ECPMovement ecpMovement(dezibot, MOVEMENT_CALIBRATION);
+ECPRook *rook;
+
+ECPReservationTable table;
+ECPPathPlanner planner(table);
+ECPPlannedPath paths[requestCount];
+
+void setup() {
+  dezibot.begin();
+  dezibot.display.flipOrientation();
+
+  if (IS_COORDINATOR) {
+    dezibot.communication.begin();
+    dezibot.communication.setGroupNumber(GROUP_NUMBER);
+    // wait for the pieces to join the mesh
+    delay(10000);
+
+    const size_t plannedCount = planner.planMoves(requests, requestCount, paths);
+    const uint32_t epoch = Communication::getNodeTime() / 1000 + START_DELAY;
+    for (size_t i = 0; i < requestCount; i++) {
+      dezibot.communication.sendMessage(paths[i].toMessage(epoch, SLOT_DURATION));
+    }
+
+    dezibot.display.clear();
+    dezibot.display.println("Planned " + String(plannedCount) + "/" + String(requestCount));
+    return;
+  }
+
+  rook = new ECPRook(
+    dezibot,
+    ecpMovement,
+    requests[PIECE_NUMBER].from,
+    PIECE_NUMBER == 0
+  );
+  rook->beginCommunication(GROUP_NUMBER);
+}
+
+void loop() {
+  if (IS_COORDINATOR) {
+    delay(1000);
+    return;
+  }
+
+  if (rook->handlePath()) {
+    dezibot.display.clear();
+    dezibot.display.println("Arrived");
+  }
+  delay(100);
+}
@@ -15,12 +15,24 @@ String ECPChessField::toString() const {
     return result;
 };
 
+bool ECPChessField::isBlack() const {
+    return (column + row) % 2 == 1;
+};
+
+uint8_t ECPChessField::toIndex() const {
+    return column + 8 * (row - 1);
+};
+
+ECPChessField ECPChessField::fromIndex(uint8_t index) {
+    return ECPChessField((ECPBoardColumn) (index % 8), index / 8 + 1);
+};
+
 bool ECPChessField::operator==(const ECPChessField& rhs) const {
     return column == rhs.column && row == rhs.row;
 };
 
 bool ECPChessField::operator!=(const ECPChessField& rhs) const {
-    return column != rhs.column && row != rhs.row;
+    return !(*this == rhs);
 };
 
 String directionToString(ECPDirection direction) {
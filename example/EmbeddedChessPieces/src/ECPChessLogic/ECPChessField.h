@@ -49,6 +49,29 @@ struct ECPChessField {
 
     String toString() const;
 
+    /**
+     * @brief Determine color of the field on the board, e.g. A1 is black
+     *        and H1 is white.
+     * 
+     * @return true if field is black, false if white
+     */
+    bool isBlack() const;
+
+    /**
+     * @brief Get index of the field, i.e. A1 == 0, B1 == 1, ..., H8 == 63.
+     * 
+     * @return uint8_t index in [0, 63]
+     */
+    uint8_t toIndex() const;
+
+    /**
+     * @brief Get field of given index, inverse of \p toIndex.
+     * 
+     * @param index Index in [0, 63]
+     * @return ECPChessField field with given index
+     */
+    static ECPChessField fromIndex(uint8_t index);
+
     bool operator==(const ECPChessField& rhs) const;
     bool operator!=(const ECPChessField& rhs) const;
 };
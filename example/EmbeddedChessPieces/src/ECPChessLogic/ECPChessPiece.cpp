@@ -13,40 +13,416 @@ ECPChessPiece::ECPChessPiece(
         if (isWhite != d.display.getColorInverted()) {
             d.display.invertColor();
         }
+        ecpMovement.setPose(initialField, currentDirection);
     };
 
+ECPChessPiece *ECPChessPiece::communicatingPiece = NULL;
+
 bool ECPChessPiece::move(ECPChessField newField) {
+    if (captured || !checkMove(newField)) {
+        return false;
+    }
+
+    const ECPChessField previousField = currentField;
+    driveTo(newField, false);
+    sendMove(previousField);
+    return true;
+};
+
+bool ECPChessPiece::capture(ECPChessField newField) {
+    if (captured || !checkMove(newField)) {
+        return false;
+    }
+
+    awaitedFieldIndex = newField.toIndex();
+    isAwaitedFieldVacated = false;
+    dezibot.communication.sendMessage(
+        "CAPTURE;" + String(newField.toIndex())
+        + ";" + String(currentField.toIndex())
+    );
+
+    const ECPChessField previousField = currentField;
+    const bool hasCaptured = driveTo(newField, true);
+    awaitedFieldIndex = -1;
+    sendMove(previousField);
+    return hasCaptured;
+};
+
+void ECPChessPiece::beginCommunication(uint32_t groupNumber) {
+    communicatingPiece = this;
+    dezibot.communication.begin();
+    dezibot.communication.setGroupNumber(groupNumber);
+    dezibot.communication.onReceive(&receivedCallback);
+
+    // the other pieces answer with their fields
+    dezibot.communication.sendMessage(
+        "HELLO;" + String(currentField.toIndex())
+    );
+};
+
+bool ECPChessPiece::handleCapture() {
+    if (shouldSendField) {
+        shouldSendField = false;
+        dezibot.communication.sendMessage(
+            "FIELD;" + String(currentField.toIndex())
+        );
+    }
+    if (captured || capturingFieldIndex == -1) {
+        return false;
+    }
+
+    const ECPChessField capturingField =
+        ECPChessField::fromIndex(capturingFieldIndex);
+    capturingFieldIndex = -1;
+
+    // the capturing piece drives along its row first, then along the column
+    // of this piece, so every lane except the one towards it stays clear
+    ECPDirection candidates[3];
+    size_t candidateCount = 0;
+    const ECPDirection nearerSide = currentField.column < E ? WEST : EAST;
+    if (capturingField.row == currentField.row) {
+        candidates[candidateCount++] =
+            capturingField.column < currentField.column ? EAST : WEST;
+    } else {
+        candidates[candidateCount++] = nearerSide;
+        candidates[candidateCount++] = nearerSide == WEST ? EAST : WEST;
+        candidates[candidateCount++] =
+            capturingField.row < currentField.row ? NORTH : SOUTH;
+    }
+
+    ECPDirection exitDirection = candidates[0];
+    size_t fewestOccupiedFields = countOccupiedFields(exitDirection);
+    for (size_t i = 1; i < candidateCount; i++) {
+        const size_t occupiedFields = countOccupiedFields(candidates[i]);
+        if (occupiedFields < fewestOccupiedFields) {
+            exitDirection = candidates[i];
+            fewestOccupiedFields = occupiedFields;
+        }
+    }
+    turnTo(exitDirection);
+
+    uint fieldsToEdge;
+    switch (exitDirection) {
+        case NORTH:
+            fieldsToEdge = 8 - currentField.row;
+            break;
+        case EAST:
+            fieldsToEdge = H - currentField.column;
+            break;
+        case SOUTH:
+            fieldsToEdge = currentField.row - 1;
+            break;
+        default:
+            fieldsToEdge = currentField.column - A;
+    }
+
+    hasNotifiedVacated = false;
+    ecpMovement.onFieldCrossed(&fieldCrossedCallback, this);
+    ecpMovement.leaveBoard(fieldsToEdge);
+    ecpMovement.onFieldCrossed(NULL);
+
+    captured = true;
+    return true;
+};
+
+bool ECPChessPiece::isCaptured() const {
+    return captured;
+};
+
+bool ECPChessPiece::followPath(
+    const ECPPlannedPath &path,
+    uint32_t epoch,
+    uint32_t slotDuration
+) {
+    // mesh time is kept in microseconds, compare differences to survive
+    // the overflow
+    const uint32_t epochMicros = epoch * 1000;
+    const uint32_t slotMicros = slotDuration * 1000;
+    isPathOverrunReported = false;
+
+    for (size_t i = 1; i < path.length; i++) {
+        const uint32_t slotStart = epochMicros
+            + (path.startSlot + i) * slotMicros;
+        while ((int32_t) (Communication::getNodeTime() - slotStart) < 0) {
+            if (isPathOverrunReported) {
+                // the reservations of the other dezibots no longer hold
+                return false;
+            }
+            delay(1);
+        }
+
+        const ECPChessField nextField = path.getField(i);
+        if (nextField == currentField) {
+            continue;
+        }
+
+        ECPDirection direction;
+        switch ((int) path.fields[i] - (int) path.fields[i - 1]) {
+            case 8:
+                direction = NORTH;
+                break;
+            case 1:
+                direction = EAST;
+                break;
+            case -8:
+                direction = SOUTH;
+                break;
+            default:
+                direction = WEST;
+        }
+
+        turnTo(direction);
+        ecpMovement.move(1, nextField, direction);
+        currentField = ecpMovement.getCurrentField();
+        drawFigureToDisplay();
+
+        // driving on would enter fields reserved by others for later slots
+        const uint32_t slotEnd = slotStart + slotMicros;
+        const bool hasOverrun =
+            (int32_t) (Communication::getNodeTime() - slotEnd) > 0;
+        if (hasOverrun || currentField != nextField) {
+            dezibot.communication.sendMessage(
+                "OVERRUN;" + String(currentField.toIndex())
+            );
+            return false;
+        }
+        if (isPathOverrunReported) {
+            return false;
+        }
+    }
+
+    turnBackToInitialDirection();
+    return true;
+};
+
+bool ECPChessPiece::handlePath() {
+    if (!hasReceivedPath) {
+        return false;
+    }
+
+    ECPPlannedPath path;
+    portENTER_CRITICAL(&receivedPathLock);
+    path = receivedPath;
+    const uint32_t epoch = receivedEpoch;
+    const uint32_t slotDuration = receivedSlotDuration;
+    hasReceivedPath = false;
+    portEXIT_CRITICAL(&receivedPathLock);
+
+    const ECPChessField previousField = currentField;
+    const bool hasReachedGoal = followPath(path, epoch, slotDuration);
+    sendMove(previousField);
+    return hasReachedGoal;
+};
+
+bool ECPChessPiece::localize(bool isPoseUnknown) {
+    if (!ecpMovement.localize(isPoseUnknown)) {
+        return false;
+    }
+
+    const ECPChessField previousField = currentField;
+    currentField = ecpMovement.getCurrentField();
+    sendMove(previousField);
+    currentDirection = ecpMovement.getCurrentDirection();
+    turnBackToInitialDirection();
+    return true;
+};
+
+ECPChessField ECPChessPiece::getCurrentField() {
+    return currentField;
+};
+
+void ECPChessPiece::receivedCallback(String &message) {
+    if (communicatingPiece == NULL) {
+        return;
+    }
+
+    const int separatorIndex = message.indexOf(';');
+    if (separatorIndex == -1) {
+        return;
+    }
+    const String type = message.substring(0, separatorIndex);
+    const String arguments = message.substring(separatorIndex + 1);
+    const int fieldIndex = arguments.toInt();
+
+    if (type == "CAPTURE"
+            && fieldIndex == communicatingPiece->currentField.toIndex()
+            && !communicatingPiece->captured) {
+        const int capturingIndex = arguments.indexOf(';');
+        if (capturingIndex != -1) {
+            communicatingPiece->capturingFieldIndex =
+                arguments.substring(capturingIndex + 1).toInt();
+        }
+    } else if (type == "VACATED") {
+        communicatingPiece->setOccupied(fieldIndex, false);
+        if (fieldIndex == communicatingPiece->awaitedFieldIndex) {
+            communicatingPiece->isAwaitedFieldVacated = true;
+        }
+    } else if (type == "PATH") {
+        ECPPlannedPath path;
+        uint32_t epoch;
+        uint32_t slotDuration;
+        if (!ECPPlannedPath::fromMessage(message, path, epoch, slotDuration)
+                || path.fields[0] != communicatingPiece->currentField.toIndex()
+                || communicatingPiece->captured) {
+            return;
+        }
+        portENTER_CRITICAL(&communicatingPiece->receivedPathLock);
+        communicatingPiece->receivedPath = path;
+        communicatingPiece->receivedEpoch = epoch;
+        communicatingPiece->receivedSlotDuration = slotDuration;
+        communicatingPiece->hasReceivedPath = true;
+        portEXIT_CRITICAL(&communicatingPiece->receivedPathLock);
+    } else if (type == "OVERRUN") {
+        communicatingPiece->isPathOverrunReported = true;
+    } else if (type == "HELLO" || type == "FIELD") {
+        communicatingPiece->setOccupied(fieldIndex, true);
+        // answering in the mesh task could flood the mesh, cf. handleCapture
+        communicatingPiece->shouldSendField |= type == "HELLO";
+    } else if (type == "MOVED") {
+        const int newIndex = arguments.indexOf(';');
+        if (newIndex != -1) {
+            communicatingPiece->setOccupied(fieldIndex, false);
+            communicatingPiece->setOccupied(
+                arguments.substring(newIndex + 1).toInt(),
+                true
+            );
+        }
+    }
+};
+
+void ECPChessPiece::fieldCrossedCallback(void *context) {
+    ECPChessPiece *piece = static_cast<ECPChessPiece *>(context);
+    if (piece->hasNotifiedVacated) {
+        return;
+    }
+    piece->hasNotifiedVacated = true;
+    piece->dezibot.communication.sendMessage(
+        "VACATED;" + String(piece->currentField.toIndex())
+    );
+};
+
+bool ECPChessPiece::checkMove(ECPChessField newField) {
     // show light depending on validity of requested movement
     if (isMoveValid(newField)) {
         setGreenLight(true);
         delay(COLOR_DELAY);
         setGreenLight(false);
-    } else {
-        setRedLight(true);
-        delay(COLOR_DELAY);
-        setRedLight(false);
-        return false;
+        return true;
     }
 
-    const int colDiff = (int) currentField.column - (int) newField.column;
-    const int rowDiff = (int) currentField.row - (int) newField.row;
+    setRedLight(true);
+    delay(COLOR_DELAY);
+    setRedLight(false);
+    return false;
+};
+
+bool ECPChessPiece::driveTo(ECPChessField newField, bool isCapture) {
+    // only the last leg enters the new field
+    bool hasApproached = true;
 
-    if (colDiff != 0) {
-        moveHorizontally(colDiff);
+    // use the tracked field instead of assuming each leg succeeded
+    if (currentField.column != newField.column) {
+        const bool isLastLeg = currentField.row == newField.row;
+        hasApproached = driveLeg(newField, true, isCapture && isLastLeg);
     }
 
-    if (rowDiff != 0) {
-        moveVertically(rowDiff);
+    if (hasApproached && currentField.row != newField.row) {
+        hasApproached = driveLeg(newField, false, isCapture);
     }
 
-    currentField = newField;
     turnBackToInitialDirection();
 
+    return hasApproached;
+};
+
+bool ECPChessPiece::driveLeg(
+    ECPChessField newField,
+    bool isHorizontal,
+    bool shouldWaitForVacated
+) {
+    const int fieldsToMove = isHorizontal
+        ? (int) currentField.column - (int) newField.column
+        : (int) currentField.row - (int) newField.row;
+    const int lastField = fieldsToMove > 0 ? 1 : -1;
+    const int fieldsBeforeWaiting = shouldWaitForVacated
+        ? fieldsToMove - lastField : fieldsToMove;
+
+    if (fieldsBeforeWaiting != 0) {
+        if (isHorizontal) {
+            moveHorizontally(fieldsBeforeWaiting);
+        } else {
+            moveVertically(fieldsBeforeWaiting);
+        }
+        currentField = ecpMovement.getCurrentField();
+    }
+    if (!shouldWaitForVacated) {
+        return true;
+    }
+
+    if (!waitForVacated()) {
+        return false;
+    }
+    if (isHorizontal) {
+        moveHorizontally((int) currentField.column - (int) newField.column);
+    } else {
+        moveVertically((int) currentField.row - (int) newField.row);
+    }
+    currentField = ecpMovement.getCurrentField();
     return true;
 };
 
-ECPChessField ECPChessPiece::getCurrentField() {
-    return currentField;
+void ECPChessPiece::setOccupied(int fieldIndex, bool isOccupied) {
+    if (fieldIndex < 0 || 63 < fieldIndex) {
+        return;
+    }
+    const uint64_t mask = (uint64_t) 1 << fieldIndex;
+    portENTER_CRITICAL(&occupancyLock);
+    if (isOccupied) {
+        occupiedFields |= mask;
+    } else {
+        occupiedFields &= ~mask;
+    }
+    portEXIT_CRITICAL(&occupancyLock);
+};
+
+size_t ECPChessPiece::countOccupiedFields(ECPDirection direction) {
+    portENTER_CRITICAL(&occupancyLock);
+    const uint64_t fields = occupiedFields;
+    portEXIT_CRITICAL(&occupancyLock);
+
+    int column = currentField.column;
+    int row = currentField.row;
+    size_t count = 0;
+    while (true) {
+        column += direction == EAST ? 1 : (direction == WEST ? -1 : 0);
+        row += direction == NORTH ? 1 : (direction == SOUTH ? -1 : 0);
+        if (column < A || H < column || row < 1 || 8 < row) {
+            return count;
+        }
+        const ECPChessField field((ECPBoardColumn) column, row);
+        count += (fields >> field.toIndex()) & 1;
+    }
+};
+
+void ECPChessPiece::sendMove(ECPChessField previousField) {
+    if (communicatingPiece != this || previousField == currentField) {
+        return;
+    }
+    dezibot.communication.sendMessage(
+        "MOVED;" + String(previousField.toIndex())
+        + ";" + String(currentField.toIndex())
+    );
+};
+
+bool ECPChessPiece::waitForVacated() {
+    const unsigned long startTime = millis();
+    while (!isAwaitedFieldVacated) {
+        if (millis() - startTime > VACATED_TIMEOUT) {
+            return false;
+        }
+        delay(10);
+    }
+    return true;
 };
 
 void ECPChessPiece::moveHorizontally(int fieldsToMove) {
@@ -64,9 +440,7 @@ void ECPChessPiece::moveHorizontally(int fieldsToMove) {
             break;
         case EAST:
             if (newDirection == WEST) {
-                ecpMovement.turnLeft(currentField, NORTH);
-                drawFigureToDisplay();
-                ecpMovement.turnLeft(currentField, WEST);
+                ecpMovement.turnAround(currentField, WEST);
                 drawFigureToDisplay();
             }
             break;
@@ -80,10 +454,7 @@ void ECPChessPiece::moveHorizontally(int fieldsToMove) {
             break;
         case WEST:
             if (newDirection == EAST) {
-                // turn around
-                ecpMovement.turnLeft(currentField, SOUTH);
-                drawFigureToDisplay();
-                ecpMovement.turnLeft(currentField, EAST);
+                ecpMovement.turnAround(currentField, EAST);
                 drawFigureToDisplay();
             }
     }
@@ -104,9 +475,7 @@ void ECPChessPiece::moveVertically(int fieldsToMove) {
     switch (currentDirection) {
         case NORTH:
             if (newDirection == SOUTH) {
-                ecpMovement.turnLeft(currentField, WEST);
-                drawFigureToDisplay();
-                ecpMovement.turnLeft(currentField, SOUTH);
+                ecpMovement.turnAround(currentField, SOUTH);
                 drawFigureToDisplay();
             }
             break;
@@ -120,9 +489,7 @@ void ECPChessPiece::moveVertically(int fieldsToMove) {
             break;
         case SOUTH:
             if (newDirection == NORTH) {
-                ecpMovement.turnLeft(currentField, EAST);
-                drawFigureToDisplay();
-                ecpMovement.turnLeft(currentField, NORTH);
+                ecpMovement.turnAround(currentField, NORTH);
                 drawFigureToDisplay();
             }
             break;
@@ -144,13 +511,30 @@ void ECPChessPiece::moveVertically(int fieldsToMove) {
     drawFigureToDisplay();
 };
 
+void ECPChessPiece::turnTo(ECPDirection newDirection) {
+    switch ((newDirection - currentDirection + 4) % 4) {
+        case 1:
+            ecpMovement.turnRight(currentField, newDirection);
+            break;
+        case 2:
+            ecpMovement.turnAround(currentField, newDirection);
+            break;
+        case 3:
+            ecpMovement.turnLeft(currentField, newDirection);
+            break;
+        default:
+            return;
+    }
+
+    currentDirection = newDirection;
+    drawFigureToDisplay();
+};
+
 void ECPChessPiece::turnBackToInitialDirection() {
     switch (currentDirection) {
         case NORTH:
             if (!isWhite) {
-                ecpMovement.turnLeft(currentField, WEST);
-                drawFigureToDisplay();
-                ecpMovement.turnLeft(currentField, SOUTH);
+                ecpMovement.turnAround(currentField, SOUTH);
                 drawFigureToDisplay();
             }
             break;
@@ -164,9 +548,7 @@ void ECPChessPiece::turnBackToInitialDirection() {
             break;
         case SOUTH:
             if (isWhite) {
-                ecpMovement.turnLeft(currentField, EAST);
-                drawFigureToDisplay();
-                ecpMovement.turnLeft(currentField, NORTH);
+                ecpMovement.turnAround(currentField, NORTH);
                 drawFigureToDisplay();
             }
             break;
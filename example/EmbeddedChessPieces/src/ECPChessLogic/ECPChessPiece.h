@@ -16,9 +16,11 @@
 
 #include "ECPChessField.h"
 #include "ECPMovement/ECPMovement.h"
+#include "ECPPlanning/ECPPlannedPath.h"
 
 
 #define COLOR_DELAY 2000
+#define VACATED_TIMEOUT 30000
 
 /**
  * @brief Abstract class for chess piece, e.g. pawn, tower etc.
@@ -62,12 +64,138 @@ public:
      * Dezibot will always face forward *before* and *after* moving, i.e. black
      * pieces will always face south and white pieces will always face north.
      * 
+     * The direct route is driven without reservations, i.e. other dezibots
+     * must not move at the same time. Collision-free planning is opt-in, cf.
+     * \p followPath.
+     * 
      * @param newField New field on which to move
      * @return true if move is valid
      * @return false otherwise
      */
     bool move(ECPChessField newField);
 
+    /**
+     * @brief Capture opponent on new field if the move is valid.
+     * 
+     * The opponent is asked to leave the board via \p Communication, see
+     * \p handleCapture. The dezibot starts moving right away and only waits
+     * for the opponent to leave the new field before the last leg onto it,
+     * instead of waiting for the opponent's whole exit.
+     * 
+     * @attention Requires \p beginCommunication on both dezibots.
+     * 
+     * @param newField Field of the opponent
+     * @return true if move is valid and the opponent left the field,
+     *         false otherwise
+     */
+    bool capture(ECPChessField newField);
+
+    /**
+     * @brief Receive capture requests via \p Communication.
+     * 
+     * Replaces the receive callback of \p dezibot.communication, only one
+     * chess piece per dezibot can communicate.
+     * 
+     * Communicating pieces also share their fields, so a captured piece can
+     * leave the board along a free lane, cf. \p handleCapture.
+     * 
+     * @param groupNumber Group number shared by all pieces of the game
+     */
+    void beginCommunication(uint32_t groupNumber);
+
+    /**
+     * @brief Leave the board if this piece was captured, call repeatedly
+     *        while waiting for moves.
+     * 
+     * The dezibot drives straight off the board to the graveyard lane next
+     * to it, preferably along its row, so captured pieces line up by row.
+     * It never leaves towards the capturing piece. Of the remaining lanes,
+     * i.e. both sides of the row and the direction in which the capturing
+     * piece approaches, the one with the fewest fields occupied by other
+     * communicating pieces is chosen, on ties the nearer side of the row.
+     * Pieces that do not communicate are unknown and may still block the
+     * lane. As soon as it crossed the edge of its field, the capturing
+     * piece is notified.
+     * 
+     * @return true if this piece was captured and left the board
+     */
+    bool handleCapture();
+
+    /**
+     * @brief True if this piece was captured and left the board.
+     * 
+     */
+    bool isCaptured() const;
+
+    /**
+     * @brief Follow path planned by \p ECPPathPlanner, e.g. received from
+     *        the dezibot coordinating the whole board.
+     * 
+     * Every step starts at the beginning of its slot in the synchronized
+     * mesh time (cf. \p Communication::getNodeTime), so all dezibots keep
+     * to their reservations. The path is not validated against the rules
+     * of this piece, captured pieces and set up moves use it as well.
+     * 
+     * If a step runs past the end of its slot, e.g. because of recovery
+     * attempts or a manual correction, or ends on another field than
+     * planned, the dezibot stops and broadcasts an \p OVERRUN message.
+     * Every dezibot following a path stops as well when receiving it, so
+     * the paths can be planned again from the current fields.
+     * 
+     * Planning is opt-in: \p move and \p capture do not reserve fields, and
+     * the paths have to be distributed by the application, e.g. by the
+     * dezibot coordinating the board as \p PATH messages, which are
+     * followed by \p handlePath.
+     * 
+     * @attention Requires \p beginCommunication to report overruns.
+     * 
+     * @param path Path starting on the current field
+     * @param epoch Mesh time in ms at which slot 0 starts
+     * @param slotDuration Duration of one slot in ms
+     * @return true if the goal was reached, false if a step ended on another
+     *         field than planned or after the end of its slot, or another
+     *         dezibot reported an overrun, and the remaining path was aborted
+     */
+    bool followPath(
+        const ECPPlannedPath &path,
+        uint32_t epoch,
+        uint32_t slotDuration
+    );
+
+    /**
+     * @brief Follow a path received as \p PATH message, call repeatedly
+     *        while waiting for moves.
+     * 
+     * Paths are broadcast to all pieces, cf. \p ECPPlannedPath::toMessage.
+     * A piece only accepts paths starting on its current field, so the
+     * coordinating dezibot does not need to know the ids of the pieces.
+     * 
+     * @attention Requires \p beginCommunication.
+     * 
+     * @return true if a path was received and its goal reached, false if no
+     *         path was received or \p followPath aborted it
+     */
+    bool handlePath();
+
+    /**
+     * @brief Determine current field with \p ECPMovement::localize instead
+     *        of trusting the initial field, e.g. after the dezibot was placed
+     *        by hand or knocked.
+     * 
+     * Afterwards, the dezibot turns back to its initial direction.
+     * 
+     * By default, this only refines the tracked pose, e.g. after a knock.
+     * If the dezibot was placed somewhere by hand, pass \p isPoseUnknown to
+     * search the whole board. This requires the beacon intensity passed to
+     * \p ECPMovement::setBeaconPosition or a second beacon added with
+     * \p ECPMovement::addBeacon.
+     * 
+     * @param isPoseUnknown true to search the whole board instead of the
+     *        surroundings of the tracked pose
+     * @return true if the field could be determined, false otherwise
+     */
+    bool localize(bool isPoseUnknown = false);
+
     /**
      * @brief Get the current field
      * 
@@ -89,7 +217,8 @@ public:
 
 protected:
     /**
-     * @brief Current field of chess piece
+     * @brief Current field of chess piece, taken from the pose tracked by
+     *        \p ecpMovement after every movement.
      * 
      */
     ECPChessField currentField;
@@ -97,6 +226,149 @@ protected:
     ECPMovement& ecpMovement;
 
 private:
+    /**
+     * @brief Piece receiving messages of \p Communication, cf.
+     *        \p beginCommunication.
+     * 
+     */
+    static ECPChessPiece *communicatingPiece;
+
+    /**
+     * @brief Handle \p CAPTURE, \p VACATED, \p PATH, \p OVERRUN and the
+     *        field messages \p HELLO, \p FIELD and \p MOVED.
+     * 
+     * Runs in the mesh task, so it only sets flags and stores the received
+     * path, handled by \p handleCapture, \p handlePath and
+     * \p waitForVacated.
+     * 
+     * @param message Received message
+     */
+    static void receivedCallback(String &message);
+
+    /**
+     * @brief Notify the capturing piece on the first field edge crossed
+     *        while leaving the board.
+     * 
+     * @param context Captured piece
+     */
+    static void fieldCrossedCallback(void *context);
+
+    /**
+     * @brief Field index of the capturing piece, or -1 if no capture was
+     *        requested.
+     * 
+     */
+    volatile int capturingFieldIndex = -1;
+
+    /**
+     * @brief Field index this piece waits to be vacated in \p capture, or -1.
+     * 
+     */
+    volatile int awaitedFieldIndex = -1;
+    volatile bool isAwaitedFieldVacated = false;
+
+    /**
+     * @brief Set if another dezibot overran a slot of its path, cf.
+     *        \p followPath.
+     * 
+     */
+    volatile bool isPathOverrunReported = false;
+
+    /**
+     * @brief Last path received for this piece, cf. \p handlePath.
+     * 
+     */
+    ECPPlannedPath receivedPath;
+    uint32_t receivedEpoch = 0;
+    uint32_t receivedSlotDuration = 0;
+    volatile bool hasReceivedPath = false;
+    portMUX_TYPE receivedPathLock = portMUX_INITIALIZER_UNLOCKED;
+
+    /**
+     * @brief Fields occupied by other communicating pieces, bit \p i for
+     *        field index \p i.
+     * 
+     */
+    uint64_t occupiedFields = 0;
+    portMUX_TYPE occupancyLock = portMUX_INITIALIZER_UNLOCKED;
+
+    /**
+     * @brief Set if another piece joined and the own field has to be sent.
+     * 
+     */
+    volatile bool shouldSendField = false;
+
+    /**
+     * @brief Mark field index as occupied or free, ignores invalid indices.
+     * 
+     */
+    void setOccupied(int fieldIndex, bool isOccupied);
+
+    /**
+     * @brief Count fields occupied by other pieces between the current field
+     *        and the edge of the board.
+     * 
+     * @param direction Direction towards the edge
+     * @return size_t number of occupied fields
+     */
+    size_t countOccupiedFields(ECPDirection direction);
+
+    /**
+     * @brief Share new field with the other pieces after a movement.
+     * 
+     * @param previousField Field before the movement
+     */
+    void sendMove(ECPChessField previousField);
+
+    bool hasNotifiedVacated = false;
+    bool captured = false;
+
+    /**
+     * @brief Show validity of a requested move with the bottom light.
+     * 
+     * @param newField New field on which to move
+     * @return true if move is valid
+     * @return false otherwise
+     */
+    bool checkMove(ECPChessField newField);
+
+    /**
+     * @brief Drive to new field, first horizontally, then vertically.
+     * 
+     * @param newField New field on which to move
+     * @param isCapture true to wait for the new field to be vacated before
+     *        the last leg onto it
+     * @return true if the new field was approached, false if it was not
+     *         vacated within \p VACATED_TIMEOUT
+     */
+    bool driveTo(ECPChessField newField, bool isCapture);
+
+    /**
+     * @brief Drive one leg of \p driveTo in a straight line.
+     * 
+     * The captured piece leaves away from this one, so on the last leg of a
+     * capture only the new field has to be vacated. The dezibot drives up
+     * to the field in front of it and only waits before the last field.
+     * 
+     * @param newField New field on which to move
+     * @param isHorizontal true to move along the row, false along the column
+     * @param shouldWaitForVacated true to wait before entering \p newField
+     * @return true if the leg was driven, false if the new field was not
+     *         vacated within \p VACATED_TIMEOUT
+     */
+    bool driveLeg(
+        ECPChessField newField,
+        bool isHorizontal,
+        bool shouldWaitForVacated
+    );
+
+    /**
+     * @brief Wait until the captured piece reported to have left the field.
+     * 
+     * @return true if the field was vacated within \p VACATED_TIMEOUT
+     */
+    bool waitForVacated();
+
     /**
      * @brief Direction in which the Dezibot representing this chess piece
      *        is facing now relative to the board.
@@ -118,6 +390,13 @@ private:
      */
     void moveVertically(int fieldsToMove);
 
+    /**
+     * @brief Turn dezibot on the current field to face a direction.
+     * 
+     * @param newDirection Direction to face afterwards
+     */
+    void turnTo(ECPDirection newDirection);
+
     /**
      * @brief Restore direction in which dezibot should face before or after a
      *        movement, i.e. black pieces turn south and white pieces north.
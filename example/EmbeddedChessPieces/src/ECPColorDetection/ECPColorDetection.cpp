@@ -5,13 +5,30 @@ ECPColorDetection::ECPColorDetection(
     ECPSignalDetection &ir
 ) : dezibot(d), ecpSignalDetection(ir) {};
 
-void ECPColorDetection::calibrateFieldColor() {
+void ECPColorDetection::calibrateFieldColor(bool forceRecalibration) {
+    const CalibrationConditions conditions = measureConditions();
+    StoredCalibration calibration;
+    if (!forceRecalibration 
+        && loadCalibration(NVS_KEY_COLOR, conditions, calibration)) {
+        fieldColorClusters.calibrate(
+            calibration.thresholdWhite,
+            calibration.thresholdBlack,
+            calibration.centerWhite,
+            calibration.centerBlack
+        );
+        return;
+    }
+
     double minWhiteBrightness = MAX_NORMALIZED_COLOR_VALUE;
     double maxBlackBrightness = 0.0;
+    double whiteBrightnessSum = 0.0;
+    double blackBrightnessSum = 0.0;
 
     for (size_t i = 0; i < CALIBRATE_FIELD_COUNT; i++) {
         const double whiteBrightness = calibrateAndMeasureColor(true);
         const double blackBrightness = calibrateAndMeasureColor(false);
+        whiteBrightnessSum += whiteBrightness;
+        blackBrightnessSum += blackBrightness;
 
         if (whiteBrightness < minWhiteBrightness) {
             minWhiteBrightness = whiteBrightness;
@@ -24,27 +41,114 @@ void ECPColorDetection::calibrateFieldColor() {
     double offsetWhite = minWhiteBrightness * THRESHOLD_OFFSET;
     double offsetBlack = maxBlackBrightness * 2 * THRESHOLD_OFFSET;
 
-    thresholdIsWhiteField = minWhiteBrightness - offsetWhite;
-    thresholdIsBlackField = maxBlackBrightness + offsetBlack;
+    calibration = { 
+        CALIBRATION_VERSION, 
+        conditions, 
+        minWhiteBrightness - offsetWhite, 
+        maxBlackBrightness + offsetBlack,
+        whiteBrightnessSum / CALIBRATE_FIELD_COUNT,
+        blackBrightnessSum / CALIBRATE_FIELD_COUNT
+    };
+    fieldColorClusters.calibrate(
+        calibration.thresholdWhite,
+        calibration.thresholdBlack,
+        calibration.centerWhite,
+        calibration.centerBlack
+    );
+    saveCalibration(NVS_KEY_COLOR, calibration);
 };
 
-void ECPColorDetection::calibrateIRFieldColor() {
+void ECPColorDetection::calibrateIRFieldColor(bool forceRecalibration) {
+    const CalibrationConditions conditions = measureConditions();
+    StoredCalibration calibration;
+    if (!forceRecalibration 
+        && loadCalibration(NVS_KEY_IR, conditions, calibration)) {
+        irFieldColorClusters.calibrate(
+            calibration.thresholdWhite,
+            calibration.thresholdBlack,
+            calibration.centerWhite,
+            calibration.centerBlack
+        );
+        return;
+    }
+
     const float irWhiteValue = calibrateAndMeasureIRColor(true);
     const float irBlackValue = calibrateAndMeasureIRColor(false);
 
     float diff =  irWhiteValue - irBlackValue;
     float offset = diff * THRESHOLD_OFFSET_IR;
 
-    thresholdIsIRWhiteField = irWhiteValue - offset;
-    thresholdIsIRBlackField = irBlackValue + offset;
+    calibration = { 
+        CALIBRATION_VERSION, 
+        conditions, 
+        irWhiteValue - offset, 
+        irBlackValue + offset,
+        irWhiteValue,
+        irBlackValue
+    };
+    irFieldColorClusters.calibrate(
+        calibration.thresholdWhite,
+        calibration.thresholdBlack,
+        calibration.centerWhite,
+        calibration.centerBlack
+    );
+    saveCalibration(NVS_KEY_IR, calibration);
+};
+
+void ECPColorDetection::clearStoredCalibration() {
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, false);
+    preferences.clear();
+    preferences.end();
 };
 
 FieldColor ECPColorDetection::getFieldColor() {
-    if (useInfraredColorDetection) {
-        return measureInfraredFieldColor();
+    FieldColor color;
+    if (usePhototransistorColorDetection && isPhototransistorCalibrated()) {
+        color = measurePhototransistorFieldColor();
+    } else if (useInfraredColorDetection) {
+        color = measureInfraredFieldColor();
+    } else {
+        color = measureFieldColor();
+    }
+
+    // a clear color also sets the state of the hysteresis of readFieldColor
+    if (color != AMBIGUOUS) {
+        lastFieldColor = color;
+    }
+    return color;
+};
+
+FieldColorReading ECPColorDetection::readFieldColor() {
+    ECPFieldColorClusters *clusters;
+    const float value = measureFieldValue(clusters);
+    const float thresholdWhite = clusters->getWhiteThreshold();
+    const float thresholdBlack = clusters->getBlackThreshold();
+
+    // position between the thresholds, 0 at black and 1 at white
+    const float range = thresholdWhite - thresholdBlack;
+    const float position = range > 0 ?
+        (value - thresholdBlack) / range : (value < thresholdWhite ? 0.0f : 1.0f);
+
+    if (1.0f <= position) {
+        lastFieldColor = WHITE_FIELD;
+    } else if (position <= 0.0f) {
+        lastFieldColor = BLACK_FIELD;
+    } else if (lastFieldColor == AMBIGUOUS) {
+        // no previous reading, decide by the closer threshold
+        lastFieldColor = position < 0.5f ? BLACK_FIELD : WHITE_FIELD;
     }
 
-    return measureFieldColor();
+    const float confidence = lastFieldColor == WHITE_FIELD ? position : 1.0f - position;
+    FieldColorReading reading = {
+        lastFieldColor,
+        constrain(confidence, 0.0f, 1.0f)
+    };
+    return reading;
+};
+
+void ECPColorDetection::resetFieldColorHysteresis() {
+    lastFieldColor = AMBIGUOUS;
 };
 
 FieldColor ECPColorDetection::getLikelyFieldColor() {
@@ -63,6 +167,57 @@ bool ECPColorDetection::getUseInfraredColorDetection() {
     return useInfraredColorDetection;
 };
 
+void ECPColorDetection::setUsePhototransistorColorDetection(bool usePT) {
+    usePhototransistorColorDetection = usePT;
+};
+
+bool ECPColorDetection::getUsePhototransistorColorDetection() {
+    return usePhototransistorColorDetection;
+};
+
+bool ECPColorDetection::calibratePhototransistor() {
+    const FieldColor color = measureFieldColor();
+    if (color == AMBIGUOUS) {
+        return false;
+    }
+    const float level = measurePhototransistorValue();
+    fieldsSincePhototransistorCalibration = 0;
+
+    // keep the tracked level of the other color
+    ECPFieldColorClusters &clusters = phototransistorFieldColorClusters;
+    float whiteLevel = clusters.getWhiteCenter();
+    float blackLevel = clusters.getBlackCenter();
+    if (color == WHITE_FIELD) {
+        whiteLevel = level;
+        hasPhototransistorWhiteLevel = true;
+    } else {
+        blackLevel = level;
+        hasPhototransistorBlackLevel = true;
+    }
+
+    // white fields reflect more light of the bottom LED than black ones
+    const float offset = (whiteLevel - blackLevel) * THRESHOLD_OFFSET_PHOTOTRANSISTOR;
+    clusters.calibrate(
+        whiteLevel - offset,
+        blackLevel + offset,
+        whiteLevel,
+        blackLevel
+    );
+    return true;
+};
+
+void ECPColorDetection::recalibratePhototransistorIfDue(size_t crossedFields) {
+    if (!usePhototransistorColorDetection) {
+        return;
+    }
+    fieldsSincePhototransistorCalibration += crossedFields;
+    if (!isPhototransistorCalibrated()
+        || PHOTOTRANSISTOR_RECALIBRATION_INTERVAL
+            <= fieldsSincePhototransistorCalibration) {
+        calibratePhototransistor();
+    }
+};
+
 void ECPColorDetection::setShouldTurnOnColorCorrectionLight(bool turnOn) {
     shouldTurnOnColorCorrectionLight = turnOn;
 };
@@ -88,6 +243,67 @@ void ECPColorDetection::turnOffColorCorrectionLight() {
 // PRIVATE FUNCTIONS
 // -----------------------------------------------------------------------------
 
+ECPColorDetection::CalibrationConditions ECPColorDetection::measureConditions() {
+    // light conditions are measured without correction light
+    turnOffColorCorrectionLight();
+    delay(DELAY_BEFORE_MEASURING);
+
+    CalibrationConditions conditions = {
+        (double) dezibot.lightDetection.getAverageValue(
+            DL_FRONT,
+            AMBIENT_MEASUREMENT_COUNT,
+            1
+        ),
+        shouldTurnOnColorCorrectionLight
+    };
+    return conditions;
+};
+
+bool ECPColorDetection::doConditionsMatch(
+    const CalibrationConditions &stored,
+    const CalibrationConditions &current
+) {
+    if (stored.isColorCorrectionLightOn != current.isColorCorrectionLightOn) {
+        return false;
+    }
+
+    const double ambientTolerance = std::max(
+        stored.ambient * AMBIENT_TOLERANCE, 
+        MIN_AMBIENT_TOLERANCE
+    );
+    const bool doesAmbientMatch = 
+        std::abs(stored.ambient - current.ambient) <= ambientTolerance;
+
+    return doesAmbientMatch;
+};
+
+bool ECPColorDetection::loadCalibration(
+    const char* key,
+    const CalibrationConditions &current,
+    StoredCalibration &calibration
+) {
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, true);
+    const size_t length = preferences.getBytes(key, &calibration, sizeof(calibration));
+    preferences.end();
+
+    if (length != sizeof(calibration) || calibration.version != CALIBRATION_VERSION) {
+        return false;
+    }
+
+    return doConditionsMatch(calibration.conditions, current);
+};
+
+void ECPColorDetection::saveCalibration(
+    const char* key, 
+    const StoredCalibration &calibration
+) {
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, false);
+    preferences.putBytes(key, &calibration, sizeof(calibration));
+    preferences.end();
+};
+
 double ECPColorDetection::calibrateAndMeasureColor(bool isWhite) {
     const String color = isWhite ? "white" : "black";
     const String request = "Calibrate " + color + "\nPlease place on\n" + color 
@@ -124,26 +340,18 @@ double ECPColorDetection::measureBrightness() {
     double cumulatedBrightness = 0.0;
 
     for (size_t i = 0; i < MEASUREMENT_COUNT; i++) {
-        delay(DELAY_BEFORE_MEASURING);
-
-        const double ambient = dezibot.colorSensor.getNormalizedAmbientValue();
-        double red = dezibot.colorSensor.getNormalizedColorValue(
-            ColorSensor::RED, 
-            ambient
-        );
-        double green = dezibot.colorSensor.getNormalizedColorValue(
-            ColorSensor::GREEN, 
-            ambient
-        );
-        double blue = dezibot.colorSensor.getNormalizedColorValue(
-            ColorSensor::BLUE, 
-            ambient
-        );
-
+        // wait for a new integration cycle, which is shorter in bright light
+        // with adaptive integration time
+        delay(std::min(
+            DELAY_BEFORE_MEASURING,
+            (int) dezibot.colorSensor.getIntegrationTime()
+        ));
+
+        const ColorSensorValues values = dezibot.colorSensor.readAllNormalized();
         cumulatedBrightness += dezibot.colorSensor.calculateBrightness(
-            red, 
-            green, 
-            blue
+            values.red, 
+            values.green, 
+            values.blue
         );
     }
     
@@ -152,8 +360,75 @@ double ECPColorDetection::measureBrightness() {
     return cumulatedBrightness / ((double) MEASUREMENT_COUNT);
 };
 
+float ECPColorDetection::measureFieldValue(ECPFieldColorClusters *&clusters) {
+    if (usePhototransistorColorDetection && isPhototransistorCalibrated()) {
+        const float value = measurePhototransistorValue();
+        phototransistorFieldColorClusters.addReading(value);
+        clusters = &phototransistorFieldColorClusters;
+        return value;
+    }
+
+    if (useInfraredColorDetection) {
+        const float irValue = ecpSignalDetection.cumulateInfraredValues();
+        irFieldColorClusters.addReading(irValue);
+        clusters = &irFieldColorClusters;
+        return irValue;
+    }
+
+    const float brightness = measureBrightness();
+    fieldColorClusters.addReading(brightness);
+    clusters = &fieldColorClusters;
+    return brightness;
+};
+
+float ECPColorDetection::measurePhototransistorValue() {
+    if (!dezibot.lightDetection.isContinuous()) {
+        dezibot.lightDetection.beginContinuous();
+    }
+    if (shouldTurnOnColorCorrectionLight) {
+        turnOnColorCorrectionLight();
+    }
+
+    // wait for a window measured at the current position
+    delay(PHOTOTRANSISTOR_WINDOW);
+    const windowStatistics statistics = 
+        dezibot.lightDetection.getWindowStatistics(
+            DL_BOTTOM,
+            PHOTOTRANSISTOR_WINDOW
+        );
+
+    if (shouldTurnOnColorCorrectionLight) {
+        turnOffColorCorrectionLight();
+    }
+    return statistics.mean;
+};
+
+bool ECPColorDetection::isPhototransistorCalibrated() {
+    return hasPhototransistorWhiteLevel && hasPhototransistorBlackLevel
+        && phototransistorFieldColorClusters.getWhiteCenter()
+            > phototransistorFieldColorClusters.getBlackCenter();
+};
+
+FieldColor ECPColorDetection::measurePhototransistorFieldColor() {
+    const float value = measurePhototransistorValue();
+    const float thresholdWhite = phototransistorFieldColorClusters.getWhiteThreshold();
+    const float thresholdBlack = phototransistorFieldColorClusters.getBlackThreshold();
+    phototransistorFieldColorClusters.addReading(value);
+
+    if (thresholdWhite <= value) {
+        return WHITE_FIELD;
+    }
+    if (value <= thresholdBlack) {
+        return BLACK_FIELD;
+    }
+    return AMBIGUOUS;
+};
+
 FieldColor ECPColorDetection::measureFieldColor() {
     const double brightness = measureBrightness();
+    const double thresholdIsWhiteField = fieldColorClusters.getWhiteThreshold();
+    const double thresholdIsBlackField = fieldColorClusters.getBlackThreshold();
+    fieldColorClusters.addReading(brightness);
 
     if (thresholdIsWhiteField <= brightness) {
         return WHITE_FIELD;
@@ -166,15 +441,19 @@ FieldColor ECPColorDetection::measureFieldColor() {
 
 FieldColor ECPColorDetection::calculateLikelyFieldColor() {
     const double brightness = measureBrightness();
+    fieldColorClusters.addReading(brightness);
 
-    int diffToWhite = std::abs(thresholdIsWhiteField - brightness);
-    int diffToBlack = std::abs(brightness - thresholdIsBlackField);
+    int diffToWhite = std::abs(fieldColorClusters.getWhiteThreshold() - brightness);
+    int diffToBlack = std::abs(brightness - fieldColorClusters.getBlackThreshold());
 
     return diffToWhite < diffToBlack ? WHITE_FIELD : BLACK_FIELD;
 };
 
 FieldColor ECPColorDetection::measureInfraredFieldColor() {
     const float irValue = ecpSignalDetection.cumulateInfraredValues();
+    const float thresholdIsIRWhiteField = irFieldColorClusters.getWhiteThreshold();
+    const float thresholdIsIRBlackField = irFieldColorClusters.getBlackThreshold();
+    irFieldColorClusters.addReading(irValue);
 
     if (thresholdIsIRWhiteField < irValue) {
         return WHITE_FIELD;
@@ -188,9 +467,10 @@ FieldColor ECPColorDetection::measureInfraredFieldColor() {
 
 FieldColor ECPColorDetection::calculateLikelyInfraredFieldColor() {
     const float irValue = ecpSignalDetection.cumulateInfraredValues();
+    irFieldColorClusters.addReading(irValue);
 
-    float diffToWhite = std::abs(thresholdIsIRWhiteField - irValue);
-    float diffToBlack = std::abs(irValue - thresholdIsIRBlackField);
+    float diffToWhite = std::abs(irFieldColorClusters.getWhiteThreshold() - irValue);
+    float diffToBlack = std::abs(irValue - irFieldColorClusters.getBlackThreshold());
 
     return diffToWhite < diffToBlack ? WHITE_FIELD : BLACK_FIELD;
 };
@@ -12,9 +12,13 @@
 #ifndef ECPColorDetection_h
 #define ECPColorDetection_h
 
+#include <Preferences.h>
+
 #include <Dezibot.h>
 #include <ECPSignalDetection/ECPSignalDetection.h>
 
+#include "ECPFieldColorClusters.h"
+
 #define COLOR_CORRECTION_LIGHT_R 43
 #define COLOR_CORRECTION_LIGHT_G 33
 #define COLOR_CORRECTION_LIGHT_B 35
@@ -31,6 +35,27 @@ enum FieldColor {
     AMBIGUOUS
 };
 
+/**
+ * @brief Field color determined from a single measurement, see
+ *        \p ECPColorDetection::readFieldColor.
+ * 
+ */
+struct FieldColorReading {
+    /**
+     * @brief Determined color, only \p BLACK_FIELD or \p WHITE_FIELD.
+     * 
+     */
+    FieldColor color;
+
+    /**
+     * @brief Confidence in \p color, i.e. [0, 1]. 1 if the measurement
+     *        passed the threshold of \p color, decreasing linearly to 0 at
+     *        the threshold of the other color.
+     * 
+     */
+    float confidence;
+};
+
 class ECPColorDetection {
 public:
     ECPColorDetection(Dezibot &d, ECPSignalDetection &ir);    
@@ -38,20 +63,44 @@ public:
     /**
      * @brief Calibrate threshold for white and black field using color sensor.
      * 
+     * Thresholds are stored in NVS together with the current light conditions.
+     * If the stored conditions match the current ones, the stored thresholds
+     * are reused and no calibration is necessary.
+     * 
+     * Afterwards, the thresholds follow slow changes of the light conditions
+     * with every measured field color (cf. \p ECPFieldColorClusters).
+     * 
+     * @param forceRecalibration true to calibrate even if stored thresholds
+     *        match the current light conditions, default is false
      */
-    void calibrateFieldColor();
+    void calibrateFieldColor(bool forceRecalibration = false);
 
     /**
      * @brief Calibrate threshold for white and black field using infrared.
      * 
+     * Thresholds are stored in NVS together with the current light conditions.
+     * If the stored conditions match the current ones, the stored thresholds
+     * are reused and no calibration is necessary.
+     * 
+     * Afterwards, the thresholds follow slow changes of the light conditions
+     * with every measured field color (cf. \p ECPFieldColorClusters).
+     * 
+     * @param forceRecalibration true to calibrate even if stored thresholds
+     *        match the current light conditions, default is false
+     */
+    void calibrateIRFieldColor(bool forceRecalibration = false);
+
+    /**
+     * @brief Remove all stored thresholds from NVS.
+     * 
      */
-    void calibrateIRFieldColor();
+    void clearStoredCalibration();
 
     /**
      * @brief Determine if measured value represents a white or black chess
      *        field.
      * 
-     * @details Uses color detection mode of \p useInfraredColorDetection flag.
+     * @details Uses the same detection mode as \p readFieldColor.
      *          Default is color detection using color sensor.
      *
      * Note that the field color detection should be calibrated for selected mode.
@@ -62,6 +111,41 @@ public:
      */
     FieldColor getFieldColor();
 
+    /**
+     * @brief Determine field color with its confidence from a single
+     *        measurement.
+     * 
+     * @details Uses the bottom daylight phototransistor (\p DL_BOTTOM) if
+     *          \p usePhototransistorColorDetection is set and
+     *          \p isPhototransistorCalibrated, i.e. once
+     *          \p calibratePhototransistor measured a white level above the
+     *          black level. Otherwise, uses the infrared phototransistors if
+     *          \p useInfraredColorDetection is set, else the color sensor.
+     *          If the phototransistor reads white fields darker than black
+     *          ones, e.g. with an inverted polarity of its ADC channel, it
+     *          never counts as calibrated and the other modes stay active
+     *          without notice.
+     * 
+     * Unlike \p getFieldColor, never \p AMBIGUOUS: the thresholds for white
+     * and black fields form a Schmitt trigger. A measurement between them
+     * keeps the color of the previous reading, with a confidence depending
+     * on how close it is to the other threshold. Without a previous reading,
+     * the closer threshold decides. So callers can decide on one
+     * measurement instead of measuring again with \p getLikelyFieldColor.
+     * 
+     * @see resetFieldColorHysteresis
+     * 
+     * @return FieldColorReading determined field color and confidence
+     */
+    FieldColorReading readFieldColor();
+
+    /**
+     * @brief Forget the previous reading of \p readFieldColor, e.g. after
+     *        the dezibot was placed on another field by hand.
+     * 
+     */
+    void resetFieldColorHysteresis();
+
     /**
      * @brief Calculate likely field color.
      * 
@@ -91,6 +175,50 @@ public:
      */
     bool getUseInfraredColorDetection();
 
+    /**
+     * @brief Set value for \p usePhototransistorColorDetection flag.
+     * 
+     * In this hybrid mode, the field color is read from the bottom daylight
+     * phototransistor (\p DL_BOTTOM), which is sampled continuously by the
+     * ADC (cf. \p LightDetection::beginContinuous). A reading only waits
+     * for \p PHOTOTRANSISTOR_WINDOW ms instead of the integration time of
+     * the color sensor, so field boundaries are detected almost immediately
+     * while driving. The color sensor is only used by
+     * \p calibratePhototransistor to find the levels of white and black
+     * fields. Until both are known, the color sensor is used as before.
+     * 
+     * @param usePT true if the phototransistor should be used, false otherwise
+     */
+    void setUsePhototransistorColorDetection(bool usePT);
+
+    /**
+     * @brief Return value of \p usePhototransistorColorDetection flag.
+     * 
+     * @return bool value of usePhototransistorColorDetection.
+     */
+    bool getUsePhototransistorColorDetection();
+
+    /**
+     * @brief Measure the level of the bottom daylight phototransistor on the
+     *        current field, labeled by the color sensor.
+     * 
+     * The dezibot has to stand still on a field, e.g. at its center.
+     * 
+     * @return true if the color sensor determined the field color, false if
+     *         it was ambiguous
+     */
+    bool calibratePhototransistor();
+
+    /**
+     * @brief Call \p calibratePhototransistor if the phototransistor is used
+     *        and its levels are unknown or were measured
+     *        \p PHOTOTRANSISTOR_RECALIBRATION_INTERVAL fields ago.
+     * 
+     * @param crossedFields Fields crossed since the last call, e.g. the
+     *        fields of a move
+     */
+    void recalibratePhototransistorIfDue(size_t crossedFields = 1);
+
     /**
      * @brief Set value for \p shouldTurnOnColorCorrectionLight flag.
      * 
@@ -123,6 +251,76 @@ protected:
     ECPSignalDetection &ecpSignalDetection;
 
 private:
+    /**
+     * @brief Light conditions during calibration, used to decide whether
+     *        stored thresholds can be reused.
+     * 
+     */
+    struct CalibrationConditions {
+        double ambient;
+        bool isColorCorrectionLightOn;
+    };
+
+    /**
+     * @brief Thresholds and conditions of a calibration as stored in NVS.
+     * 
+     */
+    struct StoredCalibration {
+        uint8_t version;
+        CalibrationConditions conditions;
+        double thresholdWhite;
+        double thresholdBlack;
+        double centerWhite;
+        double centerBlack;
+    };
+
+    /**
+     * @brief Measure current light conditions with the front daylight
+     *        phototransistor.
+     * 
+     * The color sensor faces the field below the dezibot, so its ambient
+     * light mostly depends on the field color. \p DL_FRONT measures the
+     * room's light independently of the field the dezibot stands on.
+     * 
+     * @return CalibrationConditions current conditions
+     */
+    CalibrationConditions measureConditions();
+
+    /**
+     * @brief Check whether conditions of a stored calibration still apply.
+     * 
+     * @param stored Conditions during stored calibration
+     * @param current Current conditions
+     * @return true if ambient light is within tolerance, false otherwise
+     */
+    bool doConditionsMatch(
+        const CalibrationConditions &stored,
+        const CalibrationConditions &current
+    );
+
+    /**
+     * @brief Load stored calibration if it matches the current conditions.
+     * 
+     * @param key NVS key of the calibration, see \p NVS_KEY_COLOR and 
+     *        \p NVS_KEY_IR
+     * @param current Current conditions
+     * @param calibration Loaded calibration
+     * @return true if a matching calibration was loaded, false otherwise
+     */
+    bool loadCalibration(
+        const char* key,
+        const CalibrationConditions &current,
+        StoredCalibration &calibration
+    );
+
+    /**
+     * @brief Store calibration in NVS.
+     * 
+     * @param key NVS key of the calibration
+     * @param calibration Calibration to store
+     */
+    void saveCalibration(const char* key, const StoredCalibration &calibration);
+
     /**
      * @brief Calibrate on white or black field.
      * 
@@ -150,6 +348,41 @@ private:
      */
     double measureBrightness();
 
+    /**
+     * @brief Measure brightness or cumulated infrared value, depending on
+     *        \p useInfraredColorDetection, and track it in the clusters of
+     *        the mode.
+     * 
+     * @param clusters Set to the clusters of the mode
+     * @return float measured value
+     */
+    float measureFieldValue(ECPFieldColorClusters *&clusters);
+
+    /**
+     * @brief Measure mean of the bottom daylight phototransistor within a
+     *        fresh window of \p PHOTOTRANSISTOR_WINDOW ms.
+     * 
+     * @return float mean ADC value
+     */
+    float measurePhototransistorValue();
+
+    /**
+     * @brief Check whether the levels of white and black fields are known.
+     * 
+     * @return true if \p phototransistorFieldColorClusters is calibrated
+     */
+    bool isPhototransistorCalibrated();
+
+    /**
+     * @brief Determine if the value of the bottom daylight phototransistor
+     *        clearly represents a white or black chess field.
+     * 
+     * @see calibratePhototransistor
+     * 
+     * @return FieldColor determined field color
+     */
+    FieldColor measurePhototransistorFieldColor();
+
     /**
      * @brief Determine if brightness value of color sensor clearly represents 
      *        a white or black chess field.
@@ -199,12 +432,41 @@ private:
      */
     FieldColor calculateLikelyInfraredFieldColor();
 
+    /**
+     * @brief Color of the previous unambiguous reading, the state of the
+     *        hysteresis of \p readFieldColor.
+     * 
+     */
+    FieldColor lastFieldColor = AMBIGUOUS;
+
     /**
      * @brief Flag for setting mode of color detection
      * 
      */
     bool useInfraredColorDetection = false;
 
+    /**
+     * @brief Flag for the hybrid mode using the bottom daylight
+     *        phototransistor.
+     * 
+     */
+    bool usePhototransistorColorDetection = false;
+
+    /**
+     * @brief Whether the phototransistor level of a white or black field was
+     *        measured by \p calibratePhototransistor.
+     * 
+     */
+    bool hasPhototransistorWhiteLevel = false;
+    bool hasPhototransistorBlackLevel = false;
+
+    /**
+     * @brief Fields crossed since the last calibration, cf.
+     *        \p recalibratePhototransistorIfDue.
+     * 
+     */
+    size_t fieldsSincePhototransistorCalibration = 0;
+
     /**
      * @brief Flag for setting of color correction light.
      * 
@@ -236,57 +498,72 @@ private:
     const int DELAY_BEFORE_MEASURING = 250;
     
     /**
-     * @brief Lowest value for color to be recognised as white field.
+     * @brief Default value for the lowest brightness of a white field and
+     *        the highest brightness of a black field.
      * 
      */
-    double thresholdIsWhiteField = DEFAULT_WHITE_THRESHOLD;
+    static constexpr double DEFAULT_WHITE_THRESHOLD = 220.0;
+    static constexpr double DEFAULT_BLACK_THRESHOLD = 50.0;
 
     /**
-     * @brief Highest value for color to be recognised as black field.
+     * @brief Default value for the lowest cumulated infrared value of a
+     *        white field and the highest of a black field.
      * 
      */
-    double thresholdIsBlackField = DEFAULT_BLACK_THRESHOLD;
+    static constexpr float DEFAULT_IR_WHITE_THRESHOLD = 1.0;
+    static constexpr float DEFAULT_IR_BLACK_THRESHOLD = 0.5;
 
     /**
-     * @brief Lowest cumulated infrared value to be recognised as white field.
+     * @brief Thresholds of the brightness for white and black fields.
      * 
      */
-    float thresholdIsIRWhiteField = DEFAULT_IR_WHITE_THRESHOLD;
+    ECPFieldColorClusters fieldColorClusters = ECPFieldColorClusters(
+        DEFAULT_WHITE_THRESHOLD,
+        DEFAULT_BLACK_THRESHOLD
+    );
 
     /**
-     * @brief Highest cumulated infrared value to be recognised as black field.
+     * @brief Thresholds of the cumulated infrared value for white and black
+     *        fields.
      * 
      */
-    float thresholdIsIRBlackField = DEFAULT_IR_BLACK_THRESHOLD;
+    ECPFieldColorClusters irFieldColorClusters = ECPFieldColorClusters(
+        DEFAULT_IR_WHITE_THRESHOLD,
+        DEFAULT_IR_BLACK_THRESHOLD
+    );
 
     /**
-     * @brief Default value for \p thresholdIsWhiteField.
+     * @brief Thresholds of the bottom daylight phototransistor for white and
+     *        black fields, only used once calibrated.
      * 
      */
-    const double DEFAULT_WHITE_THRESHOLD = 220.0;
+    ECPFieldColorClusters phototransistorFieldColorClusters =
+        ECPFieldColorClusters(0.0f, 0.0f);
 
     /**
-     * @brief Default value for \p thresholdIsBlackField.
+     * @brief Window in ms averaged by \p measurePhototransistorValue.
      * 
      */
-    const double DEFAULT_BLACK_THRESHOLD = 50.0;
+    static const uint32_t PHOTOTRANSISTOR_WINDOW = 5;
 
     /**
-     * @brief Default value for \p thresholdIsIRWhiteField.
+     * @brief Share of the difference between white and black level by which
+     *        the phototransistor thresholds are moved towards each other.
      * 
+     * @see phototransistorFieldColorClusters
      */
-    const float DEFAULT_IR_WHITE_THRESHOLD = 1.0;
+    static constexpr float THRESHOLD_OFFSET_PHOTOTRANSISTOR = 0.25f;
 
     /**
-     * @brief Default value for \p thresholdIsIRBlackField.
+     * @brief Fields crossed between two calibrations.
      * 
      */
-    const float DEFAULT_IR_BLACK_THRESHOLD = 0.5;
+    static const size_t PHOTOTRANSISTOR_RECALIBRATION_INTERVAL = 8;
 
     /**
      * @brief Factor to calculate threshold offset.
      * 
-     * @see thresholdIsWhiteField, thresholdIsBlackField
+     * @see fieldColorClusters
      */
     const double THRESHOLD_OFFSET = 0.025;
 
@@ -298,9 +575,43 @@ private:
      * 
      * Note that reducing the offset may result in difficulties for movement. 
      * 
-     * @see thresholdIsIRWhiteField, thresholdIsIRBlackField
+     * @see irFieldColorClusters
      */
     const float THRESHOLD_OFFSET_IR = 0.2;
+
+    /**
+     * @brief Maximum relative deviation of ambient light to reuse a stored
+     *        calibration.
+     * 
+     */
+    const double AMBIENT_TOLERANCE = 0.15;
+
+    /**
+     * @brief Maximum absolute deviation of the ambient light (raw ADC value
+     *        of \p DL_FRONT) to reuse a stored calibration. Avoids
+     *        recalibration in dim rooms where small absolute changes are
+     *        large relative ones.
+     * 
+     */
+    const double MIN_AMBIENT_TOLERANCE = 40.0;
+
+    /**
+     * @brief Number of \p DL_FRONT measurements averaged in
+     *        \p measureConditions.
+     * 
+     */
+    static const uint32_t AMBIENT_MEASUREMENT_COUNT = 20;
+
+    /**
+     * @brief Version of \p StoredCalibration, increase when changing its
+     *        layout or the meaning of the thresholds.
+     * 
+     */
+    static const uint8_t CALIBRATION_VERSION = 3;
+
+    static constexpr const char* NVS_NAMESPACE = "ecp-color";
+    static constexpr const char* NVS_KEY_COLOR = "color";
+    static constexpr const char* NVS_KEY_IR = "ir";
 };
 
 #endif // ECPColorDetection_h
@@ -0,0 +1,89 @@
+#include "ECPFieldColorClusters.h"
+
+ECPFieldColorClusters::ECPFieldColorClusters(
+    float whiteThreshold,
+    float blackThreshold
+) : whiteThreshold(whiteThreshold), blackThreshold(blackThreshold) {};
+
+void ECPFieldColorClusters::calibrate(
+    float whiteThreshold,
+    float blackThreshold,
+    float whiteCenter,
+    float blackCenter
+) {
+    this->whiteThreshold = whiteThreshold;
+    this->blackThreshold = blackThreshold;
+    this->whiteCenter = whiteCenter;
+    this->blackCenter = blackCenter;
+
+    calibratedSeparation = whiteCenter - blackCenter;
+    isTrackingEnabled = calibratedSeparation > 0.0f;
+    if (isTrackingEnabled) {
+        whiteMarginShare = (whiteCenter - whiteThreshold) / calibratedSeparation;
+        blackMarginShare = (blackThreshold - blackCenter) / calibratedSeparation;
+    }
+};
+
+void ECPFieldColorClusters::addReading(float reading) {
+    if (!isTrackingEnabled) {
+        resumeIfSeparated(reading);
+        return;
+    }
+
+    const float separation = whiteCenter - blackCenter;
+    const float middle = (whiteCenter + blackCenter) / 2;
+    if (std::abs(reading - middle) < separation * TRANSITION_SHARE / 2) {
+        // probably on the boundary between two fields
+        return;
+    }
+
+    const float newWhiteCenter = middle < reading
+        ? whiteCenter + LEARNING_RATE * (reading - whiteCenter) : whiteCenter;
+    const float newBlackCenter = middle < reading
+        ? blackCenter : blackCenter + LEARNING_RATE * (reading - blackCenter);
+
+    const float newSeparation = newWhiteCenter - newBlackCenter;
+    if (newSeparation < calibratedSeparation * MIN_SEPARATION_SHARE) {
+        // the clusters merge, e.g. while lifted, keep the last centers and
+        // thresholds until both colors are read again
+        isTrackingEnabled = false;
+        isWhiteSeen = false;
+        isBlackSeen = false;
+        return;
+    }
+    whiteCenter = newWhiteCenter;
+    blackCenter = newBlackCenter;
+    whiteThreshold = whiteCenter - whiteMarginShare * newSeparation;
+    blackThreshold = blackCenter + blackMarginShare * newSeparation;
+};
+
+void ECPFieldColorClusters::resumeIfSeparated(float reading) {
+    if (calibratedSeparation <= 0.0f) {
+        // never calibrated, the thresholds are fixed
+        return;
+    }
+
+    isWhiteSeen |= whiteThreshold <= reading;
+    isBlackSeen |= reading <= blackThreshold;
+    isTrackingEnabled = isWhiteSeen && isBlackSeen;
+};
+
+bool ECPFieldColorClusters::isTracking() const {
+    return isTrackingEnabled;
+};
+
+float ECPFieldColorClusters::getWhiteThreshold() const {
+    return whiteThreshold;
+};
+
+float ECPFieldColorClusters::getBlackThreshold() const {
+    return blackThreshold;
+};
+
+float ECPFieldColorClusters::getWhiteCenter() const {
+    return whiteCenter;
+};
+
+float ECPFieldColorClusters::getBlackCenter() const {
+    return blackCenter;
+};
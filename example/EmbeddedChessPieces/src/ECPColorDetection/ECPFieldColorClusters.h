@@ -0,0 +1,146 @@
+/**
+ * @file ECPFieldColorClusters.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Online tracking of the white and black field readings.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPFieldColorClusters_h
+#define ECPFieldColorClusters_h
+
+#include <cmath>
+
+#include <Arduino.h>
+
+/**
+ * @brief Thresholds for white and black fields that follow slow changes of
+ *        the light conditions.
+ *
+ * The readings of white and black fields form two clusters. Starting from a
+ * calibration, the center of each cluster is tracked by an exponentially
+ * weighted two-means: every reading is assigned to the closer center, which
+ * moves a little towards it. The thresholds keep their distance to the
+ * centers relative to the distance between the centers, so they also
+ * follow a changing contrast.
+ *
+ * Readings within the middle \p TRANSITION_SHARE between both centers are
+ * not assigned, as they are usually taken on the boundary between two
+ * fields. If the centers would move closer than \p MIN_SEPARATION_SHARE of
+ * their calibrated distance, tracking pauses with the last centers and
+ * thresholds. It resumes as soon as the readings separate again, i.e. one
+ * reading beyond each threshold was added.
+ *
+ */
+class ECPFieldColorClusters {
+public:
+    /**
+     * @brief Construct clusters with fixed thresholds, i.e. without
+     *        tracking until \p calibrate is called.
+     *
+     * @param whiteThreshold Lowest reading of a white field
+     * @param blackThreshold Highest reading of a black field
+     */
+    ECPFieldColorClusters(float whiteThreshold, float blackThreshold);
+
+    /**
+     * @brief Set thresholds and cluster centers, e.g. after a calibration,
+     *        and start tracking.
+     *
+     * @param whiteThreshold Lowest reading of a white field
+     * @param blackThreshold Highest reading of a black field
+     * @param whiteCenter Typical reading of a white field
+     * @param blackCenter Typical reading of a black field
+     */
+    void calibrate(
+        float whiteThreshold,
+        float blackThreshold,
+        float whiteCenter,
+        float blackCenter
+    );
+
+    /**
+     * @brief Move the closer cluster center towards a reading and update
+     *        the thresholds.
+     *
+     * @param reading Brightness or cumulated infrared value of a field
+     */
+    void addReading(float reading);
+
+    /**
+     * @brief Check whether the centers are tracked.
+     *
+     * @return true after \p calibrate, unless tracking pauses since the
+     *         centers merged
+     */
+    bool isTracking() const;
+
+    float getWhiteThreshold() const;
+    float getBlackThreshold() const;
+    float getWhiteCenter() const;
+    float getBlackCenter() const;
+
+private:
+    float whiteThreshold;
+    float blackThreshold;
+    float whiteCenter = 0.0f;
+    float blackCenter = 0.0f;
+
+    /**
+     * @brief Distance of the thresholds to their centers relative to the
+     *        distance between the centers.
+     *
+     */
+    float whiteMarginShare = 0.0f;
+    float blackMarginShare = 0.0f;
+
+    /**
+     * @brief Distance between the centers at calibration.
+     *
+     */
+    float calibratedSeparation = 0.0f;
+
+    bool isTrackingEnabled = false;
+
+    /**
+     * @brief Whether a white or black reading beyond its threshold was
+     *        added since tracking paused.
+     *
+     */
+    bool isWhiteSeen = false;
+    bool isBlackSeen = false;
+
+    /**
+     * @brief Resume paused tracking once readings beyond both thresholds
+     *        were added, starting from the centers before the pause.
+     *
+     * @param reading Reading added while tracking pauses
+     */
+    void resumeIfSeparated(float reading);
+
+    /**
+     * @brief Weight of a new reading, i.e. the centers follow changes
+     *        within about 1 / \p LEARNING_RATE readings.
+     *
+     */
+    static constexpr float LEARNING_RATE = 0.05f;
+
+    /**
+     * @brief Share of the distance between the centers around its middle
+     *        in which readings are ignored.
+     *
+     */
+    static constexpr float TRANSITION_SHARE = 0.33f;
+
+    /**
+     * @brief Share of the calibrated distance between the centers below
+     *        which tracking pauses.
+     *
+     */
+    static constexpr float MIN_SEPARATION_SHARE = 0.5f;
+};
+
+#endif // ECPFieldColorClusters_h
@@ -0,0 +1,350 @@
+#include "ECPLocalizer.h"
+
+ECPLocalizer::ECPLocalizer() {
+    resetUniform();
+};
+
+void ECPLocalizer::setBeacon(float x, float y, float intensityAtOneField) {
+    beacons[0].x = x;
+    beacons[0].y = y;
+    beacons[0].intensityAtOneField = intensityAtOneField;
+};
+
+bool ECPLocalizer::addBeacon(
+    uint16_t frequency,
+    float x,
+    float y,
+    float intensityAtOneField
+) {
+    Beacon *beacon = findBeacon(frequency);
+    if (beacon == NULL) {
+        if (beaconCount == ECPSignalDetection::MAX_BEACONS) {
+            return false;
+        }
+        beacon = &beacons[beaconCount++];
+    }
+
+    *beacon = { frequency, x, y, intensityAtOneField };
+    return true;
+};
+
+bool ECPLocalizer::hasBeaconIntensity() {
+    for (size_t i = 0; i < beaconCount; i++) {
+        if (beacons[i].intensityAtOneField > 0) {
+            return true;
+        }
+    }
+    return false;
+};
+
+size_t ECPLocalizer::getBeaconFrequencies(uint16_t *frequencies) {
+    for (size_t i = 0; i < beaconCount; i++) {
+        frequencies[i] = beacons[i].frequency;
+    }
+    return beaconCount;
+};
+
+void ECPLocalizer::resetUniform() {
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        // fields are centered on whole numbers, the board spans [-0.5, 7.5]
+        particles[i].x = randomUniform() * 8.0f - 0.5f;
+        particles[i].y = randomUniform() * 8.0f - 0.5f;
+        particles[i].heading = randomUniform() * 360.0f;
+        particles[i].weight = 1.0f / PARTICLE_COUNT;
+    }
+};
+
+void ECPLocalizer::resetAround(ECPPose pose) {
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        particles[i].x = pose.x + randomGaussian(RESET_POSITION_SPREAD);
+        particles[i].y = pose.y + randomGaussian(RESET_POSITION_SPREAD);
+        particles[i].heading = pose.heading + randomGaussian(RESET_HEADING_SPREAD);
+        particles[i].weight = 1.0f / PARTICLE_COUNT;
+    }
+};
+
+void ECPLocalizer::predict(float distance, float headingChange) {
+    const float headingDeviation = headingChange != 0 ? HEADING_NOISE : 0.0f;
+    const float distanceDeviation = std::abs(distance) * DISTANCE_NOISE;
+
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        Particle &particle = particles[i];
+        particle.heading = normalizeAngle(
+            particle.heading + headingChange + randomGaussian(headingDeviation)
+        );
+
+        const float particleDistance = distance + randomGaussian(distanceDeviation);
+        const float heading = particle.heading * DEG_TO_RAD;
+        particle.x += particleDistance * std::sin(heading);
+        particle.y += particleDistance * std::cos(heading);
+
+        if (!isOnBoard(particle.x, particle.y)) {
+            // the dezibot is assumed to stay on the board
+            particle.weight = 0.0f;
+        }
+    }
+    normalizeAndResample();
+};
+
+void ECPLocalizer::observeFieldColor(FieldColor color) {
+    FieldColorReading reading = { color, 1.0f };
+    observeFieldColor(reading);
+};
+
+void ECPLocalizer::observeFieldColor(FieldColorReading reading) {
+    if (reading.color == AMBIGUOUS || reading.confidence <= 0.0f) {
+        return;
+    }
+
+    // an uncertain reading is only slightly better than guessing
+    const float hitProbability =
+        0.5f + (COLOR_HIT_PROBABILITY - 0.5f) * reading.confidence;
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        const int column = std::round(particles[i].x);
+        const int row = std::round(particles[i].y) + 1;
+        const bool isBlack = (column + row) % 2 == 1;
+        const bool isMatch = isBlack == (reading.color == BLACK_FIELD);
+        particles[i].weight *= isMatch ? hitProbability : 1.0f - hitProbability;
+    }
+    normalizeAndResample();
+};
+
+void ECPLocalizer::observeBeacon(IRMeasurements measurements) {
+    if (!measurements.hasSignal()) {
+        return;
+    }
+
+    // bearing of the signal clockwise from the dezibot's front, cf.
+    // ECPSignalDetection::measureSignalAngle
+    const float measuredBearing = std::atan2(
+        measurements.east - measurements.west,
+        measurements.north - measurements.south
+    ) * RAD_TO_DEG;
+    weightByBeacon(beacons[0], measuredBearing, measurements.getSum());
+    normalizeAndResample();
+};
+
+void ECPLocalizer::observeBeacons(const BeaconBearing *bearings, size_t count) {
+    bool hasObserved = false;
+    for (size_t i = 0; i < count; i++) {
+        const Beacon *beacon = findBeacon(bearings[i].frequency);
+        if (beacon == NULL || !bearings[i].hasSignal) {
+            continue;
+        }
+        weightByBeacon(*beacon, bearings[i].bearing, bearings[i].intensity);
+        hasObserved = true;
+    }
+
+    if (hasObserved) {
+        normalizeAndResample();
+    }
+};
+
+bool ECPLocalizer::triangulate(
+    const BeaconBearing *bearings,
+    size_t count,
+    float heading,
+    float &x,
+    float &y
+) {
+    const Beacon *usedBeacons[2];
+    float directionsX[2];
+    float directionsY[2];
+    size_t used = 0;
+
+    for (size_t i = 0; i < count && used < 2; i++) {
+        const Beacon *beacon = findBeacon(bearings[i].frequency);
+        if (beacon == NULL || !bearings[i].hasSignal) {
+            continue;
+        }
+        const float bearing = (heading + bearings[i].bearing) * DEG_TO_RAD;
+        usedBeacons[used] = beacon;
+        directionsX[used] = std::sin(bearing);
+        directionsY[used] = std::cos(bearing);
+        used++;
+    }
+    if (used < 2) {
+        return false;
+    }
+
+    // solve beacon0 - t0 * direction0 == beacon1 - t1 * direction1
+    const float dx = usedBeacons[0]->x - usedBeacons[1]->x;
+    const float dy = usedBeacons[0]->y - usedBeacons[1]->y;
+    const float determinant =
+        directionsX[1] * directionsY[0] - directionsX[0] * directionsY[1];
+    if (std::abs(determinant) < MIN_TRIANGULATION_DETERMINANT) {
+        // lines towards the beacons are almost parallel
+        return false;
+    }
+    const float distance0 =
+        (directionsX[1] * dy - directionsY[1] * dx) / determinant;
+    const float distance1 =
+        (directionsX[0] * dy - directionsY[0] * dx) / determinant;
+    if (distance0 <= 0.0f || distance1 <= 0.0f) {
+        return false;
+    }
+
+    x = usedBeacons[0]->x - distance0 * directionsX[0];
+    y = usedBeacons[0]->y - distance0 * directionsY[0];
+    return true;
+};
+
+ECPPose ECPLocalizer::getEstimate() {
+    float x = 0.0f;
+    float y = 0.0f;
+    float sin = 0.0f;
+    float cos = 0.0f;
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        const Particle &particle = particles[i];
+        x += particle.weight * particle.x;
+        y += particle.weight * particle.y;
+        // average headings on the unit circle, e.g. 350° and 10° yield 0°
+        sin += particle.weight * std::sin(particle.heading * DEG_TO_RAD);
+        cos += particle.weight * std::cos(particle.heading * DEG_TO_RAD);
+    }
+
+    const float heading = normalizeAngle(std::atan2(sin, cos) * RAD_TO_DEG);
+    return { x, y, heading < 0 ? heading + 360.0f : heading };
+};
+
+ECPChessField ECPLocalizer::getField() {
+    const ECPPose estimate = getEstimate();
+    const int column = constrain((int) std::round(estimate.x), A, H);
+    const int row = constrain((int) std::round(estimate.y), 0, 7) + 1;
+    return ECPChessField((ECPBoardColumn) column, row);
+};
+
+float ECPLocalizer::getConfidence() {
+    const ECPChessField field = getField();
+    float confidence = 0.0f;
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        if (std::round(particles[i].x) == field.column
+            && std::round(particles[i].y) + 1 == field.row) {
+            confidence += particles[i].weight;
+        }
+    }
+    return confidence;
+};
+
+// -----------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// -----------------------------------------------------------------------------
+
+void ECPLocalizer::weightByBeacon(
+    const Beacon &beacon,
+    float measuredBearing,
+    float measuredIntensity
+) {
+    const bool useIntensity = beacon.intensityAtOneField > 0;
+
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        Particle &particle = particles[i];
+        const float dx = beacon.x - particle.x;
+        const float dy = beacon.y - particle.y;
+
+        const float bearing = std::atan2(dx, dy) * RAD_TO_DEG - particle.heading;
+        const float bearingError =
+            normalizeAngle(bearing - measuredBearing) / BEARING_DEVIATION;
+        float likelihood = std::exp(-0.5f * bearingError * bearingError);
+
+        if (useIntensity) {
+            // intensity decreases with the square of the distance
+            const float distance = std::max(
+                std::sqrt(dx * dx + dy * dy),
+                MIN_BEACON_DISTANCE
+            );
+            const float expectedIntensity =
+                beacon.intensityAtOneField / (distance * distance);
+            const float intensityError = std::log(
+                measuredIntensity / expectedIntensity
+            ) / INTENSITY_LOG_DEVIATION;
+            likelihood *= std::exp(-0.5f * intensityError * intensityError);
+        }
+
+        particle.weight *= likelihood;
+    }
+};
+
+ECPLocalizer::Beacon *ECPLocalizer::findBeacon(uint16_t frequency) {
+    for (size_t i = 0; i < beaconCount; i++) {
+        if (beacons[i].frequency == frequency) {
+            return &beacons[i];
+        }
+    }
+    return NULL;
+};
+
+void ECPLocalizer::normalizeAndResample() {
+    float sum = 0.0f;
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        sum += particles[i].weight;
+    }
+    if (sum <= 0.0f) {
+        // no hypothesis explains the observations, e.g. after being knocked
+        resetUniform();
+        return;
+    }
+
+    float squaredSum = 0.0f;
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        particles[i].weight /= sum;
+        squaredSum += particles[i].weight * particles[i].weight;
+    }
+
+    const float effectiveCount = 1.0f / squaredSum;
+    if (effectiveCount < PARTICLE_COUNT / 2.0f) {
+        resample();
+    }
+};
+
+void ECPLocalizer::resample() {
+    const float step = 1.0f / PARTICLE_COUNT;
+    float pointer = randomUniform() * step;
+    float cumulatedWeight = particles[0].weight;
+    size_t source = 0;
+
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        while (pointer > cumulatedWeight && source < PARTICLE_COUNT - 1) {
+            source++;
+            cumulatedWeight += particles[source].weight;
+        }
+        resampledParticles[i] = particles[source];
+        pointer += step;
+    }
+
+    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
+        Particle &particle = particles[i];
+        particle = resampledParticles[i];
+        particle.x += randomGaussian(ROUGHENING_POSITION);
+        particle.y += randomGaussian(ROUGHENING_POSITION);
+        particle.heading = normalizeAngle(
+            particle.heading + randomGaussian(ROUGHENING_HEADING)
+        );
+        particle.weight = step;
+    }
+};
+
+bool ECPLocalizer::isOnBoard(float x, float y) {
+    return -0.5f <= x && x <= 7.5f && -0.5f <= y && y <= 7.5f;
+};
+
+float ECPLocalizer::normalizeAngle(float angle) {
+    angle = std::fmod(angle + 180.0f, 360.0f);
+    return angle < 0 ? angle + 180.0f : angle - 180.0f;
+};
+
+float ECPLocalizer::randomUniform() {
+    // 24 bits fit the mantissa of a float, so the result never rounds to 1
+    return (esp_random() >> 8) / 16777216.0f;
+};
+
+float ECPLocalizer::randomGaussian(float standardDeviation) {
+    if (standardDeviation == 0) {
+        return 0.0f;
+    }
+    // Box-Muller transform, 1 - u avoids the logarithm of 0
+    const float u = 1.0f - randomUniform();
+    const float v = randomUniform();
+    return standardDeviation * std::sqrt(-2.0f * std::log(u))
+        * std::cos(2.0f * PI * v);
+};
@@ -0,0 +1,364 @@
+/**
+ * @file ECPLocalizer.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Monte Carlo localization of the dezibot on the chess board.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPLocalizer_h
+#define ECPLocalizer_h
+
+#include <cmath>
+
+#include <Arduino.h>
+#include <esp_random.h>
+
+#include <ECPChessLogic/ECPChessField.h>
+#include <ECPColorDetection/ECPColorDetection.h>
+#include <ECPMovement/ECPPoseTracker.h>
+#include <ECPSignalDetection/ECPSignalDetection.h>
+
+/**
+ * @brief Particle filter estimating the pose of the dezibot on the board.
+ *
+ * Every particle is one hypothesis of the pose in board coordinates (cf.
+ * \p ECPPose). Hypotheses are moved by odometry and weighted by how well
+ * they explain
+ * - the measured field color, using the checkerboard pattern of the board,
+ * - the bearing of the infrared beacon, i.e. the dezibot running
+ *   <tt>examples/ir_emitter.ino</tt>, relative to the dezibot's front and
+ * - the intensity of the beacon, which decreases with the distance.
+ *
+ * All particles live in fixed arrays inside the object, no heap memory is
+ * used.
+ *
+ */
+class ECPLocalizer {
+public:
+    /**
+     * @brief Construct a new localizer with the beacon at
+     *        \p DEFAULT_BEACON_X, \p DEFAULT_BEACON_Y and particles spread
+     *        uniformly over the board.
+     *
+     */
+    ECPLocalizer();
+
+    /**
+     * @brief Set position of the infrared beacon flashing with
+     *        \p ECPSignalDetection::BEACON_FREQUENCY.
+     *
+     * @param x Position in board coordinates, may lie outside of the board
+     * @param y Position in board coordinates, may lie outside of the board
+     * @param intensityAtOneField Sum of the normalized infrared measurements
+     *        at a distance of one field, or 0 to ignore the intensity
+     */
+    void setBeacon(float x, float y, float intensityAtOneField);
+
+    /**
+     * @brief Add another beacon flashing with its own frequency, or move
+     *        the beacon with this frequency.
+     *
+     * @param frequency Carrier frequency of the beacon in Hz
+     * @param x Position in board coordinates, may lie outside of the board
+     * @param y Position in board coordinates, may lie outside of the board
+     * @param intensityAtOneField Sum of the normalized infrared measurements
+     *        at a distance of one field, or 0 to ignore the intensity
+     * @return true if the beacon was added, false if there are already
+     *         \p ECPSignalDetection::MAX_BEACONS beacons
+     */
+    bool addBeacon(
+        uint16_t frequency,
+        float x,
+        float y,
+        float intensityAtOneField
+    );
+
+    /**
+     * @brief Get carrier frequencies of all beacons, e.g. for
+     *        \p ECPSignalDetection::measureBeacons.
+     *
+     * @param frequencies Set to the frequencies, needs space for
+     *        \p ECPSignalDetection::MAX_BEACONS entries
+     * @return size_t number of beacons
+     */
+    size_t getBeaconFrequencies(uint16_t *frequencies);
+
+    /**
+     * @brief Check whether the intensity of any beacon is known.
+     *
+     * Without intensity, a bearing with unknown heading and the periodic
+     * field colors hardly narrow down particles spread over the whole
+     * board, cf. \p resetUniform.
+     *
+     * @return true if a beacon has a positive \p intensityAtOneField
+     */
+    bool hasBeaconIntensity();
+
+    /**
+     * @brief Spread particles uniformly over the board with any heading,
+     *        e.g. if the dezibot was placed somewhere by hand.
+     *
+     */
+    void resetUniform();
+
+    /**
+     * @brief Spread particles around a known pose, e.g. the tracked pose
+     *        after the dezibot was knocked.
+     *
+     * @param pose Most likely pose
+     */
+    void resetAround(ECPPose pose);
+
+    /**
+     * @brief Move particles by odometry, adding noise.
+     *
+     * The heading is changed first, then the particles move forward.
+     *
+     * @param distance Distance driven forward in fields
+     * @param headingChange Clockwise rotation in degrees
+     */
+    void predict(float distance, float headingChange);
+
+    /**
+     * @brief Weight particles by the measured field color.
+     *
+     * @param color Measured field color, \p AMBIGUOUS is ignored
+     */
+    void observeFieldColor(FieldColor color);
+
+    /**
+     * @brief Weight particles by a field color reading, trusting it
+     *        according to its confidence.
+     *
+     * @param reading Reading of \p ECPColorDetection::readFieldColor, a
+     *        confidence of 0 is ignored
+     */
+    void observeFieldColor(FieldColorReading reading);
+
+    /**
+     * @brief Weight particles by bearing and intensity of the beacon.
+     *
+     * @param measurements Measurements of the lateral infrared sensors,
+     *        ignored if they contain no signal
+     */
+    void observeBeacon(IRMeasurements measurements);
+
+    /**
+     * @brief Weight particles by bearing and intensity of several beacons
+     *        measured at once.
+     *
+     * @param bearings Measured bearings, beacons without signal or with an
+     *        unknown frequency are ignored
+     * @param count Number of bearings
+     */
+    void observeBeacons(const BeaconBearing *bearings, size_t count);
+
+    /**
+     * @brief Calculate position from the bearings of the first two beacons
+     *        with signal and a known heading by intersecting the lines
+     *        towards the beacons.
+     *
+     * A single beacon only yields a line, so its bearing cannot fix the
+     * position on its own.
+     *
+     * @param bearings Measured bearings, cf. \p observeBeacons
+     * @param count Number of bearings
+     * @param heading Heading of the dezibot clockwise from north in degrees
+     * @param x Set to the position in board coordinates
+     * @param y Set to the position in board coordinates
+     * @return true if two beacons were measured and their lines intersect in
+     *         front of both, false otherwise
+     */
+    bool triangulate(
+        const BeaconBearing *bearings,
+        size_t count,
+        float heading,
+        float &x,
+        float &y
+    );
+
+    /**
+     * @brief Get weighted mean of all particles.
+     *
+     * @return ECPPose estimated pose
+     */
+    ECPPose getEstimate();
+
+    /**
+     * @brief Get field of the estimated pose, clamped to the board.
+     *
+     * @return ECPChessField estimated field
+     */
+    ECPChessField getField();
+
+    /**
+     * @brief Get share of the particles lying on the estimated field.
+     *
+     * @return float confidence in [0, 1]
+     */
+    float getConfidence();
+
+    /**
+     * @brief Number of particles.
+     *
+     */
+    static const size_t PARTICLE_COUNT = 256;
+
+    /**
+     * @brief Default position of the beacon, centered one field beyond row 8.
+     *
+     */
+    static constexpr float DEFAULT_BEACON_X = 3.5f;
+    static constexpr float DEFAULT_BEACON_Y = 8.5f;
+
+private:
+    struct Beacon {
+        uint16_t frequency;
+        float x;
+        float y;
+        float intensityAtOneField;
+    };
+
+    struct Particle {
+        float x;
+        float y;
+        float heading;
+        float weight;
+    };
+
+    /**
+     * @brief Multiply weights by the likelihood of a beacon measurement
+     *        without normalizing them.
+     *
+     * @param beacon Measured beacon
+     * @param measuredBearing Bearing clockwise from the dezibot's front
+     * @param measuredIntensity Sum of the normalized measurements
+     */
+    void weightByBeacon(
+        const Beacon &beacon,
+        float measuredBearing,
+        float measuredIntensity
+    );
+
+    /**
+     * @brief Get beacon with given frequency.
+     *
+     * @return Beacon* the beacon, or NULL if unknown
+     */
+    Beacon *findBeacon(uint16_t frequency);
+
+    /**
+     * @brief Normalize weights to a sum of 1 and resample if the effective
+     *        number of particles dropped below half of \p PARTICLE_COUNT.
+     *
+     * If no particle explains the observation at all, start again with
+     * \p resetUniform.
+     *
+     */
+    void normalizeAndResample();
+
+    /**
+     * @brief Draw \p PARTICLE_COUNT particles proportionally to their
+     *        weights using systematic resampling.
+     *
+     */
+    void resample();
+
+    /**
+     * @brief Check if position lies on the board.
+     *
+     */
+    static bool isOnBoard(float x, float y);
+
+    /**
+     * @brief Normalize angle in degrees to [-180, 180), particles keep their
+     *        heading in this range.
+     *
+     */
+    static float normalizeAngle(float angle);
+
+    /**
+     * @brief Uniformly distributed random number in [0, 1).
+     *
+     */
+    static float randomUniform();
+
+    /**
+     * @brief Normally distributed random number with given standard deviation.
+     *
+     */
+    static float randomGaussian(float standardDeviation);
+
+    Particle particles[PARTICLE_COUNT];
+    Particle resampledParticles[PARTICLE_COUNT];
+
+    /**
+     * @brief Known beacons, the first one flashes with
+     *        \p ECPSignalDetection::BEACON_FREQUENCY.
+     *
+     */
+    Beacon beacons[ECPSignalDetection::MAX_BEACONS] = {{
+        ECPSignalDetection::BEACON_FREQUENCY,
+        DEFAULT_BEACON_X,
+        DEFAULT_BEACON_Y,
+        0.0f
+    }};
+    size_t beaconCount = 1;
+
+    /**
+     * @brief Noise of the odometry, relative for the distance and in degrees
+     *        per rotation for the heading.
+     *
+     */
+    static constexpr float DISTANCE_NOISE = 0.2f;
+    static constexpr float HEADING_NOISE = 5.0f;
+
+    /**
+     * @brief Spread of the particles in \p resetAround in fields and degrees.
+     *
+     */
+    static constexpr float RESET_POSITION_SPREAD = 0.5f;
+    static constexpr float RESET_HEADING_SPREAD = 30.0f;
+
+    /**
+     * @brief Noise added to resampled particles, so duplicates do not
+     *        collapse to one hypothesis while standing still.
+     *
+     */
+    static constexpr float ROUGHENING_POSITION = 0.03f;
+    static constexpr float ROUGHENING_HEADING = 2.0f;
+
+    /**
+     * @brief Probability that the measured field color is correct.
+     *
+     */
+    static constexpr float COLOR_HIT_PROBABILITY = 0.85f;
+
+    /**
+     * @brief Standard deviation of the measured beacon bearing in degrees
+     *        and of the logarithm of the measured beacon intensity.
+     *
+     */
+    static constexpr float BEARING_DEVIATION = 20.0f;
+    static constexpr float INTENSITY_LOG_DEVIATION = 0.5f;
+
+    /**
+     * @brief Distance in fields below which the beacon intensity is assumed
+     *        to saturate.
+     *
+     */
+    static constexpr float MIN_BEACON_DISTANCE = 0.5f;
+
+    /**
+     * @brief Minimum determinant of the lines towards two beacons in
+     *        \p triangulate, i.e. the sine of the angle between them.
+     *
+     */
+    static constexpr float MIN_TRIANGULATION_DETERMINANT = 0.17f;
+};
+
+#endif // ECPLocalizer_h
@@ -6,76 +6,137 @@ ECPMovement::ECPMovement(
 ) : dezibot(dezibot),
     ecpSignalDetection(ECPSignalDetection(dezibot)),
     ecpColorDetection(ECPColorDetection(dezibot, ecpSignalDetection)),
-    movementCalibration(movementCalibration) {};
+    movementCalibration(movementCalibration),
+    rotationController(PIDController(ROTATION_PID_CONFIG)),
+    rotationModel(ECPRotationModel(ROTATION_TIME_FACTOR)),
+    poseTracker(movementCalibration),
+    speedProfile(movementCalibration) {
+        poseTracker.begin(dezibot.motion);
+    };
 
 void ECPMovement::move(
     uint numberOfFields, 
     ECPChessField intendedField, 
     ECPDirection intendedDirection
 ) {
-    for (size_t i = 0; i < numberOfFields; i++) {
-        bool wasSuccessfulMovement = moveToNextField();
-        
-        if (!wasSuccessfulMovement) {
+    if (numberOfFields == 0) {
+        // driving to the field center would move half a field
+        return;
+    }
+
+    uint movedFields = 0;
+    size_t recoveryAttempt = 0;
+
+    startDriving(true);
+    while (movedFields < numberOfFields) {
+        const FieldMovementResult result = moveToNextField();
+        if (result == FIELD_REACHED) {
+            movedFields++;
+            setDrivingDuty(speedProfile.getDuty(movedFields, numberOfFields));
+            continue;
+        }
+        dezibot.motion.stop();
+
+        if (result == FIELD_BLOCKED) {
+            // pushing against an obstacle again would not help
+            displayForwardMovementCorrectionRequest(
+                intendedField,
+                intendedDirection,
+                true
+            );
+            return;
+        }
+
+        // most likely the dezibot drifted and drives along a field boundary,
+        // hence align to the driving direction again and continue
+        if (recoveryAttempt == RECOVERY_ATTEMPTS 
+            || !alignToDirection(intendedDirection)) {
             // request position to the final destination
             displayForwardMovementCorrectionRequest(
                 intendedField,
                 intendedDirection
             );
+            return;
+        }
+        recoveryAttempt++;
+        // restart at the calibrated duty, the next field ramps up again
+        startDriving(false);
+    }
+    driveToFieldCenter();
+    // the color sensor can only measure while standing still
+    ecpColorDetection.recalibratePhototransistorIfDue(movedFields);
+
+    const FieldColor expectedColor = getExpectedFieldColor(intendedField);
+    if (ecpColorDetection.getFieldColor() != expectedColor
+        && !searchFieldColor(expectedColor, intendedDirection)) {
+        displayForwardMovementCorrectionRequest(
+            intendedField,
+            intendedDirection
+        );
+    }
+};
 
-            // end further movement
+void ECPMovement::leaveBoard(uint fieldsToEdge) {
+    startDriving(true);
+    for (uint i = 0; i < fieldsToEdge; i++) {
+        if (moveToNextField() != FIELD_REACHED) {
             break;
         }
     }
+
+    // the board edge lies half a field after the last crossing
+    const long timeSinceCrossing = millis() - lastEdgeCrossing;
+    const long boardEdgeTime = fieldTime / 2 - timeSinceCrossing;
+    if (boardEdgeTime > 0) {
+        delay(boardEdgeTime);
+    }
+    if (fieldCrossingObserver != NULL) {
+        fieldCrossingObserver(fieldCrossingContext);
+    }
+
+    delay(fieldTime * (BOARD_EXIT_DISTANCE - 0.5f));
+    dezibot.motion.waitForCompletion(dezibot.motion.stop());
+};
+
+void ECPMovement::onFieldCrossed(
+    FieldCrossingObserver observer,
+    void *context
+) {
+    fieldCrossingObserver = observer;
+    fieldCrossingContext = context;
 };
 
 void ECPMovement::turnLeft(
     ECPChessField currentField, 
     ECPDirection intendedDirection
 ) {
-    const FieldColor startColor = ecpColorDetection.getFieldColor();
-    const int initialAngle = ecpSignalDetection.measureDezibotAngle();
-    
     // if dezibot initially faces 270°, subtract 90° to turn left, resulting
     // in the dezibot facing 180°
-    // add 360 before applying modulo to prevent negative values
-    const int goalAngle = (initialAngle - 90 + 360) % 360;
-    
-    const bool wasRotationSuccessful = rotateToAngle(goalAngle, initialAngle);
-
-    delay(MEASURING_DELAY); // for better measuring results
-    const FieldColor currentColor = ecpColorDetection.getFieldColor();
-    if (currentColor != startColor || !wasRotationSuccessful) {
-        displayRotationCorrectionRequest(currentField, intendedDirection);
-    }
+    turn(-90, currentField, intendedDirection);
 };
 
 void ECPMovement::turnRight(
     ECPChessField currentField, 
     ECPDirection intendedDirection
 ) {
-    const FieldColor startColor = ecpColorDetection.getFieldColor();
-    const int initialAngle = ecpSignalDetection.measureDezibotAngle();
-
-    // if dezibot initially faces 180°, add 90° to turn left, resulting
+    // if dezibot initially faces 180°, add 90° to turn right, resulting
     // in the dezibot facing 270°
-    const int goalAngle = (initialAngle + 90) % 360;
-
-    const bool wasRotationSuccessful = rotateToAngle(goalAngle, initialAngle);
+    turn(90, currentField, intendedDirection);
+};
 
-    delay(MEASURING_DELAY); // for better measuring results
-    const FieldColor currentColor = ecpColorDetection.getFieldColor();
-    if (currentColor != startColor || !wasRotationSuccessful) {
-        displayRotationCorrectionRequest(currentField, intendedDirection);
-    }
+void ECPMovement::turnAround(
+    ECPChessField currentField, 
+    ECPDirection intendedDirection
+) {
+    turn(180, currentField, intendedDirection);
 };
 
-void ECPMovement::calibrateFieldColor() {
-    ecpColorDetection.calibrateFieldColor();
+void ECPMovement::calibrateFieldColor(bool forceRecalibration) {
+    ecpColorDetection.calibrateFieldColor(forceRecalibration);
 };
 
-void ECPMovement::calibrateIRFieldColor() {
-    ecpColorDetection.calibrateIRFieldColor();
+void ECPMovement::calibrateIRFieldColor(bool forceRecalibration) {
+    ecpColorDetection.calibrateIRFieldColor(forceRecalibration);
 };
 
 void ECPMovement::setUseInfraredColorDetection(bool useIR) {
@@ -86,38 +147,224 @@ void ECPMovement::setShouldTurnOnColorCorrectionLight(bool turnOn) {
     ecpColorDetection.setShouldTurnOnColorCorrectionLight(turnOn);
 };
 
+void ECPMovement::onRotationControllerUpdate(PIDObserver observer) {
+    rotationController.onUpdate(observer);
+};
+
+void ECPMovement::resetRotationModel() {
+    rotationModel.reset();
+};
+
+void ECPMovement::setPose(ECPChessField field, ECPDirection direction) {
+    poseTracker.setPose(field, direction);
+};
+
+ECPPose ECPMovement::getPose() {
+    return poseTracker.getPose();
+};
+
+ECPChessField ECPMovement::getCurrentField() {
+    return poseTracker.getField();
+};
+
+ECPDirection ECPMovement::getCurrentDirection() {
+    return poseTracker.getDirection();
+};
+
+bool ECPMovement::localize(bool isPoseUnknown) {
+    // the dezibot may have been moved to a field of another color
+    ecpColorDetection.resetFieldColorHysteresis();
+    ECPPose lastPose = poseTracker.getPose();
+
+    uint16_t frequencies[ECPSignalDetection::MAX_BEACONS];
+    BeaconBearing bearings[ECPSignalDetection::MAX_BEACONS];
+    const size_t beaconCount = localizer.getBeaconFrequencies(frequencies);
+
+    // two beacons fix the position, given the tracked heading
+    ECPPose triangulatedPose = lastPose;
+    bool isTriangulated = false;
+    if (beaconCount > 1) {
+        ecpSignalDetection.measureBeacons(frequencies, beaconCount, bearings);
+        isTriangulated = localizer.triangulate(
+            bearings,
+            beaconCount,
+            lastPose.heading,
+            triangulatedPose.x,
+            triangulatedPose.y
+        );
+    }
+
+    if (isTriangulated) {
+        localizer.resetAround(triangulatedPose);
+    } else if (!isPoseUnknown) {
+        localizer.resetAround(lastPose);
+    } else if (localizer.hasBeaconIntensity()) {
+        localizer.resetUniform();
+    } else {
+        // the whole board cannot be narrowed down by bearing and colors
+        return false;
+    }
+
+    for (size_t step = 0; step < LOCALIZATION_STEPS; step++) {
+        delay(MEASURING_DELAY); // for better measuring results
+        localizer.observeFieldColor(ecpColorDetection.readFieldColor());
+        if (beaconCount > 1) {
+            ecpSignalDetection.measureBeacons(frequencies, beaconCount, bearings);
+            localizer.observeBeacons(bearings, beaconCount);
+        } else {
+            localizer.observeBeacon(ecpSignalDetection.measureIR());
+        }
+
+        if (localizer.getConfidence() >= LOCALIZATION_CONFIDENCE) {
+            poseTracker.setPose(localizer.getEstimate());
+            return true;
+        }
+
+        // observe from another position, turning every step keeps the
+        // dezibot within a small square instead of leaving the board
+        if (step % 2 == 0) {
+            moveForward(LOCALIZATION_MOVE_TIME);
+        } else {
+            rotateRight(calculateRotationTime(90));
+        }
+        predictLocalization(lastPose);
+    }
+
+    return false;
+};
+
+void ECPMovement::setBeaconPosition(float x, float y, float intensityAtOneField) {
+    localizer.setBeacon(x, y, intensityAtOneField);
+};
+
+bool ECPMovement::calibrateBearing() {
+    ECPBearingCalibration &calibration =
+        ecpSignalDetection.getBearingCalibration();
+    calibration.beginSpin();
+
+    // unwrap the tracked heading, which is normalized to [0, 360)
+    float lastHeading = poseTracker.getPose().heading;
+    float heading = 0.0f;
+
+    dezibot.motion.rotateClockwise(0, CALIBRATION_SPIN_SPEED);
+    for (size_t i = 0; i < ECPBearingCalibration::MAX_SPIN_SAMPLES; i++) {
+        const float headingBefore = heading;
+        const IRMeasurements measurements = ecpSignalDetection.measureIR();
+
+        const float currentHeading = poseTracker.getPose().heading;
+        heading += std::remainder(currentHeading - lastHeading, 360.0f);
+        lastHeading = currentHeading;
+
+        // the measurement window spans the rotation since the last sample
+        calibration.addSpinSample(measurements, (headingBefore + heading) / 2);
+        if (heading >= CALIBRATION_SPIN_ANGLE) {
+            break;
+        }
+    }
+    dezibot.motion.stop();
+
+    return calibration.finishSpin();
+};
+
+bool ECPMovement::addBeacon(
+    uint16_t frequency,
+    float x,
+    float y,
+    float intensityAtOneField
+) {
+    return localizer.addBeacon(frequency, x, y, intensityAtOneField);
+};
+
 // -----------------------------------------------------------------------------
 // PRIVATE FUNCTIONS
 // -----------------------------------------------------------------------------
 
-void ECPMovement::moveForward(int timeMovement) {
-    dezibot.motion.move(0, movementCalibration);
-    delay(timeMovement);
-    dezibot.motion.stop();
+MotionResult ECPMovement::moveForward(int timeMovement) {
+    return dezibot.motion.waitForCompletion(
+        dezibot.motion.move(timeMovement, movementCalibration)
+    );
 };
 
-bool ECPMovement::moveToNextField() {
-    FieldColor startColor = ecpColorDetection.getFieldColor();
-    if (startColor == AMBIGUOUS) {
-        startColor = ecpColorDetection.getLikelyFieldColor();
-    }
+FieldMovementResult ECPMovement::moveToNextField() {
+    // the hysteresis of the readings ignores the boundary between two
+    // fields, so a single measurement is enough
+    const FieldColor startColor = ecpColorDetection.readFieldColor().color;
     
     const FieldColor wantedColor = startColor == BLACK_FIELD ? 
         WHITE_FIELD : BLACK_FIELD;
     FieldColor currentColor = startColor;
-    int currentIteration = 0;
+    const unsigned long startTime = millis();
+    unsigned long crossingTime = startTime;
 
     while (currentColor != wantedColor) {
-        if (currentIteration == MAX_ITERATIONS) {
-            return false;
+        if (millis() - startTime > MAX_ITERATIONS * FORWARD_TIME) {
+            return FIELD_MISSED;
         }
-        currentIteration++;
 
-        moveForward(FORWARD_TIME);
-        currentColor = ecpColorDetection.getFieldColor();
+        // the edge was crossed at some time during the measurement
+        const unsigned long measurementStart = millis();
+        currentColor = ecpColorDetection.readFieldColor().color;
+        crossingTime = measurementStart + (millis() - measurementStart) / 2;
+
+        // the movement runs without time limit, so it only ends if stalled
+        if (dezibot.motion.waitForCompletion(drivingSequence, 0) == MOTION_STALLED) {
+            return FIELD_BLOCKED;
+        }
     }
 
-    return true;
+    recordEdgeCrossing(crossingTime);
+    poseTracker.onFieldBoundaryCrossed();
+    if (fieldCrossingObserver != NULL) {
+        fieldCrossingObserver(fieldCrossingContext);
+    }
+    return FIELD_REACHED;
+};
+
+void ECPMovement::startDriving(bool isAtFieldCenter) {
+    drivingSequence = dezibot.motion.move(0, movementCalibration);
+    drivingDuty = movementCalibration;
+    lastEdgeCrossing = millis();
+    hasLastEdgeCrossing = false;
+    isDrivingFromCenter = isAtFieldCenter;
+};
+
+void ECPMovement::setDrivingDuty(uint duty) {
+    if (duty == drivingDuty) {
+        return;
+    }
+    dezibot.motion.setBaseValue(duty);
+    drivingDuty = duty;
+};
+
+void ECPMovement::driveToFieldCenter() {
+    const long timeSinceCrossing = millis() - lastEdgeCrossing;
+    const long remainingTime = fieldTime / 2 - timeSinceCrossing;
+    if (remainingTime > 0) {
+        delay(remainingTime);
+    }
+    dezibot.motion.waitForCompletion(dezibot.motion.stop());
+};
+
+void ECPMovement::recordEdgeCrossing(unsigned long crossingTime) {
+    float measuredFieldTime = 0.0f;
+    if (hasLastEdgeCrossing) {
+        measuredFieldTime = crossingTime - lastEdgeCrossing;
+    } else if (isDrivingFromCenter) {
+        // the first edge lies half a field away from the center
+        measuredFieldTime = 2.0f * (crossingTime - lastEdgeCrossing);
+    }
+    lastEdgeCrossing = crossingTime;
+    hasLastEdgeCrossing = true;
+
+    if (measuredFieldTime < MIN_FIELD_TIME || MAX_FIELD_TIME < measuredFieldTime) {
+        return;
+    }
+    if (drivingDuty != movementCalibration) {
+        speedProfile.addMeasurement(drivingDuty, measuredFieldTime, fieldTime);
+        return;
+    }
+    fieldTime += FIELD_TIME_SMOOTHING * (measuredFieldTime - fieldTime);
+    poseTracker.setFieldTime(std::round(fieldTime));
 };
 
 void ECPMovement::displayRotationCorrectionRequest(
@@ -132,13 +379,18 @@ void ECPMovement::displayRotationCorrectionRequest(
     dezibot.display.print(request);
     delay(MANUAL_CORRECTION_TIME);
     dezibot.display.clear();
+    // the dezibot was placed by hand, the last field color is meaningless
+    ecpColorDetection.resetFieldColorHysteresis();
+    poseTracker.setPose(currentField, intendedDirection);
 };
 
 void ECPMovement::displayForwardMovementCorrectionRequest(
     ECPChessField intendedField, 
-    ECPDirection intendedDirection
+    ECPDirection intendedDirection,
+    bool wasBlocked
 ) {
-    String request = "Faulty movement\nPlease correct\nmy position\nwithin " 
+    const String reason = wasBlocked ? "Blocked movement" : "Faulty movement";
+    String request = reason + "\nPlease correct\nmy position\nwithin " 
         + String(MANUAL_CORRECTION_TIME / 1000) + "s to\n\n> " 
         + intendedField.toString() + " " + directionToString(intendedDirection) 
         + "\n\n Thank you!";
@@ -146,39 +398,97 @@ void ECPMovement::displayForwardMovementCorrectionRequest(
     dezibot.display.print(request);
     delay(MANUAL_CORRECTION_TIME);
     dezibot.display.clear();
+    // the dezibot was placed by hand, the last field color is meaningless
+    ecpColorDetection.resetFieldColorHysteresis();
+    poseTracker.setPose(intendedField, intendedDirection);
+};
+
+void ECPMovement::turn(
+    int angle,
+    ECPChessField currentField,
+    ECPDirection intendedDirection
+) {
+    const FieldColor startColor = ecpColorDetection.getFieldColor();
+    const int initialAngle = ecpSignalDetection.measureDezibotAngle();
+    if (!hasBeaconReference) {
+        setBeaconReference(initialAngle, poseTracker.getDirection());
+    }
+
+    // add 360 before applying modulo to prevent negative values
+    const int goalAngle = (initialAngle + angle + 360) % 360;
+
+    int finalAngle;
+    const bool wasRotationSuccessful = 
+        rotateToAngle(goalAngle, initialAngle, finalAngle);
+
+    delay(MEASURING_DELAY); // for better measuring results
+    const FieldColor currentColor = ecpColorDetection.getFieldColor();
+    if (currentColor == startColor && wasRotationSuccessful) {
+        // beacon based rotation is more accurate than the integrated gyroscope
+        poseTracker.setHeading(intendedDirection);
+        setBeaconReference(finalAngle, intendedDirection);
+    } else if (!recoverRotation(currentField, intendedDirection)) {
+        displayRotationCorrectionRequest(currentField, intendedDirection);
+    }
 };
 
-bool ECPMovement::rotateToAngle(int goalAngle, int initialAngle) {
-    int currentAngle = initialAngle;
-    int difference = goalAngle - currentAngle;
+bool ECPMovement::rotateToAngle(
+    int goalAngle,
+    int initialAngle,
+    int &finalAngle
+) {
+    // measured without rounding, so small remaining differences are not
+    // rounded away or up to a whole degree
+    float currentAngle = initialAngle;
+    // normalize to [-180, 180], e.g. 359° and 1° only differ by 2°
+    float difference = std::remainder(goalAngle - currentAngle, 360.0f);
     size_t currentIteration = 0;
 
+    rotationController.reset();
+
     bool shouldContinueRotation = std::abs(difference) > ROTATION_TOLERANCE
         && currentIteration < MAX_ITERATIONS;
 
     while (shouldContinueRotation) {
-        int normalizedDifference = ((difference + 180 + 360) % 360) - 180;
-        uint rotationTime = calculateRotationTime(normalizedDifference);
-
-        if (normalizedDifference == 0 || normalizedDifference == -180) {
+        // one controller step per iteration, the wall-clock time of an
+        // iteration mostly consists of rotating and measuring
+        const int commandedAngle = std::round(
+            rotationController.update(difference, ROTATION_PID_STEP)
+        );
+        uint rotationTime = calculateRotationTime(commandedAngle);
+
+        const bool isLeftRotation = commandedAngle <= 0;
+        if (commandedAngle == 0 || commandedAngle == -180) {
             // exactly opposed to goal angle, rotation direction does not matter
             rotateLeft(rotationTime);
-        } else if (normalizedDifference < 0) {
+        } else if (commandedAngle < 0) {
             rotateLeft(rotationTime);
         } else {
             rotateRight(rotationTime);
         }
 
         delay(MEASURING_DELAY); // for better measuring results
-        currentAngle = ecpSignalDetection.measureDezibotAngle();
+        const float previousAngle = currentAngle;
+        currentAngle = ecpSignalDetection.measureDezibotBearing();
+
+        // fit rotation model if dezibot rotated in commanded direction,
+        // rotating left decreases the angle
+        const float rotatedAngle =
+            std::remainder(currentAngle - previousAngle, 360.0f);
+        if (isLeftRotation == (rotatedAngle < 0)) {
+            rotationModel.addMeasurement(rotationTime, rotatedAngle);
+        }
 
-        difference = goalAngle - currentAngle;
+        difference = std::remainder(goalAngle - currentAngle, 360.0f);
         
         currentIteration++;
         shouldContinueRotation = std::abs(difference) > ROTATION_TOLERANCE
             && currentIteration < MAX_ITERATIONS;
     }
 
+    rotationModel.save();
+    finalAngle = (int) std::round(currentAngle) % 360;
+
     if (currentIteration == MAX_ITERATIONS) {
         // rotation failed
         return false;
@@ -189,18 +499,114 @@ bool ECPMovement::rotateToAngle(int goalAngle, int initialAngle) {
 };
 
 void ECPMovement::rotateLeft(uint movementTime) {
-    dezibot.motion.right.setSpeed(ROTATION_SPEED);
-    delay(movementTime);
-    dezibot.motion.right.setSpeed(0);
+    if (movementTime == 0) {
+        // a duration of 0 would rotate until the next command
+        return;
+    }
+    dezibot.motion.waitForCompletion(
+        dezibot.motion.rotateAntiClockwise(movementTime, ROTATION_SPEED)
+    );
 };
 
 void ECPMovement::rotateRight(uint movementTime) {
-    dezibot.motion.left.setSpeed(ROTATION_SPEED);
-    delay(movementTime);
-    dezibot.motion.left.setSpeed(0);
+    if (movementTime == 0) {
+        return;
+    }
+    dezibot.motion.waitForCompletion(
+        dezibot.motion.rotateClockwise(movementTime, ROTATION_SPEED)
+    );
+};
+
+bool ECPMovement::recoverRotation(
+    ECPChessField currentField,
+    ECPDirection intendedDirection
+) {
+    if (!hasBeaconReference) {
+        return false;
+    }
+
+    const FieldColor expectedColor = getExpectedFieldColor(currentField);
+    for (size_t attempt = 0; attempt < RECOVERY_ATTEMPTS; attempt++) {
+        const bool isAligned = alignToDirection(intendedDirection);
+
+        delay(MEASURING_DELAY); // for better measuring results
+        if (isAligned && ecpColorDetection.getFieldColor() == expectedColor) {
+            return true;
+        }
+
+        // rotating around one leg moved the dezibot off its field
+        searchFieldColor(expectedColor, intendedDirection);
+    }
+    return false;
+};
+
+bool ECPMovement::alignToDirection(ECPDirection direction) {
+    if (!hasBeaconReference) {
+        return false;
+    }
+
+    const int initialAngle = ecpSignalDetection.measureDezibotAngle();
+    const int goalAngle = (beaconReferenceAngle + direction * 90) % 360;
+    int finalAngle;
+    if (!rotateToAngle(goalAngle, initialAngle, finalAngle)) {
+        return false;
+    }
+
+    poseTracker.setHeading(direction);
+    return true;
+};
+
+bool ECPMovement::searchFieldColor(
+    FieldColor expectedColor,
+    ECPDirection direction
+) {
+    // search in front of the dezibot first
+    for (size_t burst = 0; burst < SEARCH_BURSTS; burst++) {
+        if (moveForward(SEARCH_TIME) == MOTION_STALLED) {
+            break;
+        }
+        if (ecpColorDetection.getFieldColor() == expectedColor) {
+            return true;
+        }
+    }
+
+    // go back past the starting point, as the dezibot cannot drive backwards
+    const ECPDirection oppositeDirection = (ECPDirection) ((direction + 2) % 4);
+    if (!alignToDirection(oppositeDirection)) {
+        return false;
+    }
+    bool wasFound = false;
+    for (size_t burst = 0; burst < 2 * SEARCH_BURSTS && !wasFound; burst++) {
+        if (moveForward(SEARCH_TIME) == MOTION_STALLED) {
+            break;
+        }
+        wasFound = ecpColorDetection.getFieldColor() == expectedColor;
+    }
+
+    return alignToDirection(direction) && wasFound;
+};
+
+void ECPMovement::predictLocalization(ECPPose &lastPose) {
+    const ECPPose pose = poseTracker.getPose();
+    const float dx = pose.x - lastPose.x;
+    const float dy = pose.y - lastPose.y;
+    const float headingChange = pose.heading - lastPose.heading;
+
+    // the tracked position is only used for the driven distance, as its
+    // absolute value is unknown before localization
+    localizer.predict(std::sqrt(dx * dx + dy * dy), headingChange);
+    lastPose = pose;
+};
+
+void ECPMovement::setBeaconReference(int angle, ECPDirection direction) {
+    beaconReferenceAngle = (angle - direction * 90 + 360) % 360;
+    hasBeaconReference = true;
+};
+
+FieldColor ECPMovement::getExpectedFieldColor(ECPChessField field) {
+    return field.isBlack() ? BLACK_FIELD : WHITE_FIELD;
 };
 
 uint ECPMovement::calculateRotationTime(int normalizedAngleDifference) {
-    float rotationTime = ROTATION_TIME_FACTOR * std::abs(normalizedAngleDifference);
-    return std::round(rotationTime);
+    return rotationModel.predictRotationTime(normalizedAngleDifference);
 };
@@ -16,8 +16,13 @@
 
 #include <ECPChessLogic/ECPChessField.h>
 #include <ECPColorDetection/ECPColorDetection.h>
+#include <ECPLocalization/ECPLocalizer.h>
 #include <ECPSignalDetection/ECPSignalDetection.h>
 
+#include "ECPPoseTracker.h"
+#include "ECPRotationModel.h"
+#include "ECPSpeedProfile.h"
+
 #define FORWARD_TIME 750
 #define ROTATION_SPEED 8192
 
@@ -26,6 +31,37 @@
 
 #define MANUAL_CORRECTION_TIME 10000
 
+/**
+ * @brief Outcome of moving to the next field.
+ * 
+ */
+enum FieldMovementResult {
+    FIELD_REACHED,
+
+    /**
+     * @brief Field color did not change in time, e.g. because the dezibot
+     *        drifted along a field boundary.
+     * 
+     */
+    FIELD_MISSED,
+
+    /**
+     * @brief Motion detected a stall, e.g. because the dezibot is pushing
+     *        against another piece or the board edge.
+     * 
+     */
+    FIELD_BLOCKED
+};
+
+/**
+ * @brief Callback notified whenever the dezibot crossed a field edge while
+ *        moving forward.
+ * 
+ * Called while the dezibot keeps driving, so it should return quickly.
+ * 
+ */
+typedef void (*FieldCrossingObserver)(void *context);
+
 class ECPMovement {
 public:
     /**
@@ -42,6 +78,16 @@ public:
     /**
      * @brief Move chess piece given number of fields forward.
      * 
+     * The dezibot drives continuously over all fields, timing the edge
+     * crossings, and stops at the center of the last field. Long movements
+     * speed up in between, following \p speedProfile.
+     * 
+     * If a field could not be reached, the dezibot aligns to
+     * \p intendedDirection using the infrared beacon and continues. If it
+     * does not stand on the color of \p intendedField afterwards, it
+     * searches for it with short movements. The user is only asked to
+     * correct the position if this recovery fails or the dezibot is blocked.
+     * 
      * @param numberOfFields Number of fields the dezibot should move forward
      * @param intendedField Field of the dezibot
      * @param intendedDirection Direction the dezibot should look at after movement
@@ -52,9 +98,36 @@ public:
         ECPDirection intendedDirection
     );
 
+    /**
+     * @brief Drive straight off the board, e.g. to the graveyard lane next
+     *        to the board after being captured.
+     * 
+     * Counts the edge crossings up to the last field of the board, then
+     * continues by the estimated field time until the dezibot is half a
+     * field beyond the board edge. There is no recovery, as there is no
+     * field to return to.
+     * 
+     * @param fieldsToEdge Number of fields between the current field and the
+     *        last field before the board edge
+     */
+    void leaveBoard(uint fieldsToEdge);
+
+    /**
+     * @brief Register observer notified on every field edge crossed in
+     *        \p move and \p leaveBoard, including the board edge.
+     * 
+     * @param observer callback, or NULL to remove it
+     * @param context passed to \p observer
+     */
+    void onFieldCrossed(FieldCrossingObserver observer, void *context = NULL);
+
     /**
      * @brief Turn 90 degrees left.
      * 
+     * If the rotation failed, the dezibot recovers automatically, see
+     * \p recoverRotation. The user is only asked to correct the position if
+     * this recovery fails.
+     * 
      * @param currentField field of the dezibot
      * @param intendedDirection direction the dezibot should look at after rotation
      * 
@@ -67,6 +140,10 @@ public:
     /**
      * @brief Turn 90 degrees right.
      * 
+     * If the rotation failed, the dezibot recovers automatically, see
+     * \p recoverRotation. The user is only asked to correct the position if
+     * this recovery fails.
+     * 
      * @param currentField field of the dezibot
      * @param intendedDirection direction the dezibot should look at after rotation
      * 
@@ -76,6 +153,25 @@ public:
      */
     void turnRight(ECPChessField currentField, ECPDirection intendedDirection);
 
+    /**
+     * @brief Turn 180 degrees.
+     * 
+     * Unlike two calls of \p turnLeft, the field color and the beacon angle
+     * are only measured once before and once after the rotation.
+     * 
+     * If the rotation failed, the dezibot recovers automatically, see
+     * \p recoverRotation. The user is only asked to correct the position if
+     * this recovery fails.
+     * 
+     * @param currentField field of the dezibot
+     * @param intendedDirection direction the dezibot should look at after rotation
+     * 
+     * @details Uses \p ECPSignalDetection::measureDezibotAngle internally to
+     *          rotate dezibot to the correct angle. Make sure to place a
+     *          dezibot running <tt>examples/ir_emitter.ino</tt> within reach!
+     */
+    void turnAround(ECPChessField currentField, ECPDirection intendedDirection);
+
     /**
      * @brief Calibrate threshold for white and black field using color sensor.
      * 
@@ -83,10 +179,14 @@ public:
      * 
      * Needed to adapt to current light conditions
      * Default values may compromise movement on the chess field
+     * Stored thresholds are reused if light conditions did not change
+     * 
+     * @param forceRecalibration true to calibrate even if stored thresholds
+     *        match the current light conditions, default is false
      * 
      * @see ECPColorDetection::calibrateFieldColor
      */
-    void calibrateFieldColor();
+    void calibrateFieldColor(bool forceRecalibration = false);
 
     /**
      * @brief Calibrate threshold for white and black field using infrared.
@@ -95,10 +195,14 @@ public:
      * 
      * Needed to adapt to current light conditions
      * Default values may compromise movement on the chess field
+     * Stored thresholds are reused if light conditions did not change
+     * 
+     * @param forceRecalibration true to calibrate even if stored thresholds
+     *        match the current light conditions, default is false
      * 
      * @see ECPColorDetection::calibrateIRFieldColor
      */
-    void calibrateIRFieldColor();
+    void calibrateIRFieldColor(bool forceRecalibration = false);
 
     /**
      * @brief Set value for \p ECPColorDetection::useInfraredColorDetection flag.
@@ -114,6 +218,138 @@ public:
      */
     void setShouldTurnOnColorCorrectionLight(bool turnOn);
 
+    /**
+     * @brief Register observer for the heading controller used in
+     *        \p rotateToAngle, e.g. to plot its step response.
+     * 
+     * @param observer callback receiving every controller update, or NULL
+     */
+    void onRotationControllerUpdate(PIDObserver observer);
+
+    /**
+     * @brief Discard the fitted rotation model of this dezibot and start
+     *        again with \p ROTATION_TIME_FACTOR.
+     * 
+     * Use e.g. after changing the dezibot's legs or motors.
+     * 
+     * @see ECPRotationModel
+     */
+    void resetRotationModel();
+
+    /**
+     * @brief Set tracked pose, e.g. after placing the dezibot on the board.
+     * 
+     * @param field Field the dezibot is standing on
+     * @param direction Direction the dezibot is facing
+     * 
+     * @see ECPPoseTracker::setPose
+     */
+    void setPose(ECPChessField field, ECPDirection direction);
+
+    /**
+     * @brief Get pose tracked while moving.
+     * 
+     * @return ECPPose current pose in board coordinates
+     */
+    ECPPose getPose();
+
+    /**
+     * @brief Get field the dezibot is standing on according to the tracked
+     *        pose.
+     * 
+     * @return ECPChessField current field
+     */
+    ECPChessField getCurrentField();
+
+    /**
+     * @brief Get direction the dezibot is facing according to the tracked
+     *        pose.
+     * 
+     * @return ECPDirection current direction
+     */
+    ECPDirection getCurrentDirection();
+
+    /**
+     * @brief Find the field the dezibot is standing on, e.g. after it was
+     *        placed on the board by hand or knocked.
+     * 
+     * Alternately observe field color and infrared beacon and move the
+     * dezibot a little in a small square, until \p localizer is confident
+     * about the field or \p LOCALIZATION_STEPS are exceeded. On success,
+     * the tracked pose is set to the result.
+     * 
+     * By default, the search starts around the tracked pose. With two or
+     * more beacons (cf. \p addBeacon), it starts around the position
+     * triangulated from their bearings and the tracked heading instead, if
+     * both are received. Otherwise, searching the whole board requires the
+     * intensity of a beacon, as the bearing with unknown heading and the
+     * checkerboard colors are ambiguous.
+     * 
+     * @details Make sure to place a dezibot running
+     *          <tt>examples/ir_emitter.ino</tt> at the position passed to
+     *          \p setBeaconPosition.
+     * 
+     * @param isPoseUnknown true to search the whole board instead of the
+     *        surroundings of the tracked pose
+     * @return true if the field could be determined, false otherwise, e.g.
+     *         if the pose is unknown, no beacon intensity is set and the
+     *         position could not be triangulated
+     */
+    bool localize(bool isPoseUnknown = false);
+
+    /**
+     * @brief Set position of the infrared beacon used by \p localize.
+     * 
+     * @param x Position in board coordinates, cf. \p ECPPose
+     * @param y Position in board coordinates, cf. \p ECPPose
+     * @param intensityAtOneField Sum of the normalized infrared measurements
+     *        at a distance of one field, or 0 to only use the bearing
+     * 
+     * @see ECPLocalizer::setBeacon
+     */
+    void setBeaconPosition(float x, float y, float intensityAtOneField = 0.0f);
+
+    /**
+     * @brief Calibrate the beacon bearing of this dezibot by spinning it
+     *        once on the spot.
+     * 
+     * While rotating clockwise, the beacon is measured continuously and the
+     * heading integrated from the gyroscope is used as ground truth (cf.
+     * \p ECPBearingCalibration). The calibration is stored in NVS, so it
+     * only has to be repeated after changing the sensors.
+     * 
+     * @details Make sure to place a dezibot running
+     *          <tt>examples/beacon/beacon.ino</tt> within reach.
+     * 
+     * @return true if the calibration succeeded, false if the beacon was
+     *         not measured during a full rotation
+     */
+    bool calibrateBearing();
+
+    /**
+     * @brief Add another infrared beacon flashing with its own frequency.
+     *
+     * With more than one beacon, \p localize measures all beacons within
+     * the same window, separated by frequency.
+     *
+     * @param frequency Carrier frequency of the beacon in Hz, cf.
+     *        \p InfraredLED::sendFrequency and
+     *        <tt>examples/beacon/beacon.ino</tt>
+     * @param x Position in board coordinates, cf. \p ECPPose
+     * @param y Position in board coordinates, cf. \p ECPPose
+     * @param intensityAtOneField Sum of the normalized infrared measurements
+     *        at a distance of one field, or 0 to only use the bearing
+     * @return true if the beacon was added, false if there are too many
+     *
+     * @see ECPLocalizer::addBeacon
+     */
+    bool addBeacon(
+        uint16_t frequency,
+        float x,
+        float y,
+        float intensityAtOneField = 0.0f
+    );
+
 protected:
     Dezibot &dezibot;
     ECPSignalDetection ecpSignalDetection;
@@ -127,6 +363,94 @@ protected:
      */
     const uint movementCalibration;
 
+    /**
+     * @brief Heading controller for \p rotateToAngle.
+     * 
+     * The error is the remaining angle difference in degrees, the output is
+     * the angle to rotate in the next iteration. The integral term overcomes
+     * rotations that are too short to move the dezibot at all, the derivative
+     * term damps overshooting.
+     * 
+     * @see ROTATION_PID_CONFIG
+     */
+    PIDController rotationController;
+
+    /**
+     * @brief Model of the time needed to rotate by a given angle.
+     * 
+     * Fitted on every rotation in \p rotateToAngle and persisted in NVS.
+     * 
+     * @see calculateRotationTime
+     */
+    ECPRotationModel rotationModel;
+
+    /**
+     * @brief Pose of the dezibot, updated by the motor task and corrected on
+     *        every field colour transition and successful rotation.
+     * 
+     */
+    ECPPoseTracker poseTracker;
+
+    /**
+     * @brief Beacon angle measured while facing north, i.e. the angle
+     *        measured while facing a direction is this angle plus the
+     *        direction times 90°.
+     * 
+     * Learned from the first measurement of a rotation and updated after
+     * every successful rotation.
+     * 
+     * @see setBeaconReference
+     */
+    int beaconReferenceAngle = 0;
+    bool hasBeaconReference = false;
+
+    /**
+     * @brief Estimated time in ms to cross one field with
+     *        \p movementCalibration, smoothed over the measured intervals
+     *        between edge crossings.
+     * 
+     * Also passed to \p poseTracker as its speed estimate.
+     * 
+     */
+    float fieldTime = ECPPoseTracker::DEFAULT_FIELD_TIME;
+
+    /**
+     * @brief Sequence of the move command started by \p startDriving, used
+     *        to detect stalls.
+     * 
+     */
+    uint32_t drivingSequence = 0;
+
+    /**
+     * @brief Duty profile of \p move, adapted by the measured field times.
+     * 
+     */
+    ECPSpeedProfile speedProfile;
+
+    /**
+     * @brief Duty the dezibot is currently driving with in \p move.
+     * 
+     */
+    uint drivingDuty = 0;
+
+    /**
+     * @brief Time of the last edge crossing or the start of the movement, if
+     *        the dezibot started at a field center, in ms.
+     * 
+     */
+    unsigned long lastEdgeCrossing = 0;
+    bool hasLastEdgeCrossing = false;
+    bool isDrivingFromCenter = false;
+
+    FieldCrossingObserver fieldCrossingObserver = NULL;
+    void *fieldCrossingContext = NULL;
+
+    /**
+     * @brief Particle filter used by \p localize.
+     * 
+     */
+    ECPLocalizer localizer;
+
 private:
     /**
      * @brief Move straight for the given amount of time.
@@ -134,24 +458,71 @@ private:
      * To minimize drift, a break is implemented after each movement.
      * 
      * @param timeMovement in ms - how long the dezibot should move.
+     * @return MotionResult \p MOTION_STALLED if the dezibot is blocked
+     */
+    MotionResult moveForward(int timeMovement);
+
+    /**
+     * @brief Keep moving straight until the edge to the next field is crossed.
+     * 
+     * Expects the dezibot to be moving already, see \p startDriving. The
+     * field color is measured continuously while the motor task drives, so
+     * the time of the edge crossing is known within one measurement. Gives
+     * up after <tt>MAX_ITERATIONS * FORWARD_TIME</tt> ms or as soon as the
+     * stall detection of \p Motion aborted the movement.
+     * 
+     * Records the edge crossing and corrects the tracked pose once the field
+     * color changed.
+     * 
+     * @return FieldMovementResult \p FIELD_REACHED if fieldColors indicate
+     *         successful movement, otherwise the reason of the failure
+     */
+    FieldMovementResult moveToNextField();
+
+    /**
+     * @brief Start moving straight without time limit.
+     * 
+     * @param isAtFieldCenter true if the dezibot starts at the center of a
+     *        field, so the first edge crossing yields a field time estimate
+     */
+    void startDriving(bool isAtFieldCenter);
+
+    /**
+     * @brief Change duty of the running forward movement, cf.
+     *        \p Motion::setBaseValue.
+     * 
+     * @param duty New duty of both motors
+     */
+    void setDrivingDuty(uint duty);
+
+    /**
+     * @brief Continue from the last edge crossing to the center of the field
+     *        and stop.
+     * 
+     * The center is reached half of \p fieldTime after the crossing.
+     * 
      */
-    void moveForward(int timeMovement);
+    void driveToFieldCenter();
 
     /**
-     * @brief Move straight to the next field.
+     * @brief Update \p fieldTime with the time since the previous edge
+     *        crossing, or since the start if the dezibot started at a field
+     *        center.
      * 
-     * Default interval of movement before checking the field color
-     * is defined in MOVEMENT_TIME and MOVEMENT_BREAK.
+     * Only times measured at \p movementCalibration update \p fieldTime,
+     * faster segments are passed to \p speedProfile instead.
      * 
-     * @return true if fieldColors indicate successful movement
-     * @return false if fieldColors indicate faulty movement
+     * @param crossingTime Time of the edge crossing in ms, cf. \p millis
      */
-    bool moveToNextField();
+    void recordEdgeCrossing(unsigned long crossingTime);
 
     /**
      * Print request to correct dezibot on the board after faulty rotation.
      * 
-     * The user has 10 seconds to correct the position and direction of the dezibot
+     * Only used if automatic recovery failed.
+     * 
+     * The user has 10 seconds to correct the position and direction of the dezibot,
+     * afterwards the tracked pose is reset to the requested one.
      * 
      * @param currentField Field of the dezibot
      * @param intendedDirection Direction the dezibot should look at after rotation
@@ -164,13 +535,37 @@ private:
     /**
      * Print request to correct dezibot on the board after faulty forward movement.
      * 
-     * The user has 10 seconds to correct the position and direction of the dezibot
+     * Only used if automatic recovery failed.
+     * 
+     * The user has 10 seconds to correct the position and direction of the dezibot,
+     * afterwards the tracked pose is reset to the requested one.
      * 
      * @param intendedField Field of the dezibot
      * @param intendedDirection Direction the dezibot should look at after movement
+     * @param wasBlocked true if the movement failed because the dezibot was
+     *        blocked, default is false
      */
     void displayForwardMovementCorrectionRequest(
         ECPChessField intendedField,
+        ECPDirection intendedDirection,
+        bool wasBlocked = false
+    );
+
+    /**
+     * @brief Rotate by given angle relative to the measured initial angle and
+     *        check the result, used by \p turnLeft, \p turnRight and
+     *        \p turnAround.
+     * 
+     * Compare the field color before and after the rotation and recover if
+     * the rotation failed or the color changed.
+     * 
+     * @param angle Angle to rotate in degrees, negative values rotate left
+     * @param currentField Field of the dezibot
+     * @param intendedDirection Direction the dezibot should look at after rotation
+     */
+    void turn(
+        int angle,
+        ECPChessField currentField,
         ECPDirection intendedDirection
     );
 
@@ -178,7 +573,8 @@ private:
      * @brief Rotate dezibot from measured initial angle to specified goal angle.
      * 
      * This function uses an incremental approach. Based on the difference of
-     * the two angles, incrementally rotate the bot toward the goal, considering
+     * the two angles, \p rotationController determines the angle to rotate
+     * next, incrementally rotating the bot toward the goal, considering
      * the tolerance specified in \p ROTATION_TOLERANCE.
      * 
      * If the rotation could not be completed successfully after a certain
@@ -187,14 +583,15 @@ private:
      * @param goalAngle The target angle to which the dezibot is to be rotated.
      * @param initialAngle Measured initial angle of the dezibot, see
      *                     \p EcpSignalDetection::measureDezibotAngle.
+     * @param finalAngle Set to the last measured angle of the dezibot.
      * 
      * @return bool true if rotation was successful, false otherwise
      * 
      * @see calculateRotationTime() for details on how the rotation time is computed.
      * @see rotateLeft and \p rotateRight for the actual rotation implementations.
-     * @see EcpSignalDetection::measureDezibotAngle for how the current angle is measured.
+     * @see EcpSignalDetection::measureDezibotBearing for how the current angle is measured.
      */
-    bool rotateToAngle(int goalAngle, int initialAngle);
+    bool rotateToAngle(int goalAngle, int initialAngle, int &finalAngle);
 
     /**
      * @brief Rotate dezibot to the left (counter-clockwise) for a specified duration.
@@ -202,7 +599,10 @@ private:
      * @param movementTime Duration for which the bot should rotate left in
      *                     milliseconds.
      * 
-     * @details Use right motor of the dezibot (<tt>dezibot.motion.right<\tt>).
+     * @details Use right motor of the dezibot (<tt>dezibot.motion.rotateAntiClockwise</tt>).
+     *          The motors cannot run in reverse, so the dezibot pivots
+     *          around its left wheel and leaves the field center, cf.
+     *          \p recoverRotation.
      */
     void rotateLeft(uint movementTime);
 
@@ -212,27 +612,92 @@ private:
      * @param movementTime Duration for which the bot should rotate right in
      *                     milliseconds.
      * 
-     * @details Use left motor of the dezibot (<tt>dezibot.motion.left</tt>).
+     * @details Use left motor of the dezibot (<tt>dezibot.motion.rotateClockwise</tt>).
+     *          The dezibot pivots around its right wheel, cf. \p rotateLeft.
      */
     void rotateRight(uint movementTime);
 
+    /**
+     * @brief Recover from a faulty rotation without user interaction.
+     * 
+     * Align to \p intendedDirection using \p beaconReferenceAngle and check
+     * whether the dezibot still stands on \p currentField by comparing the
+     * measured color with the color of the field on the board. If not,
+     * search the field using \p searchFieldColor. Try at most
+     * \p RECOVERY_ATTEMPTS times.
+     * 
+     * @param currentField Field of the dezibot
+     * @param intendedDirection Direction the dezibot should look at after rotation
+     * @return true if recovery was successful, false otherwise
+     */
+    bool recoverRotation(
+        ECPChessField currentField,
+        ECPDirection intendedDirection
+    );
+
+    /**
+     * @brief Rotate to face given board direction using the infrared beacon.
+     * 
+     * @param direction Direction the dezibot should look at
+     * @return true if rotation was successful, false if it failed or no
+     *         \p beaconReferenceAngle is known yet
+     */
+    bool alignToDirection(ECPDirection direction);
+
+    /**
+     * @brief Search field with given color using short movements.
+     * 
+     * Move forward in bursts of \p SEARCH_TIME first. As the dezibot cannot
+     * move backwards, turn around and search behind the starting point if the
+     * color was not found, then align to \p direction again.
+     * 
+     * @param expectedColor Color of the field to search
+     * @param direction Direction the dezibot is and should be facing afterwards
+     * @return true if the color was found, false otherwise
+     */
+    bool searchFieldColor(FieldColor expectedColor, ECPDirection direction);
+
+    /**
+     * @brief Pass the odometry since \p lastPose to \p localizer.
+     * 
+     * @param lastPose Tracked pose at the previous call, set to the current one
+     */
+    void predictLocalization(ECPPose &lastPose);
+
+    /**
+     * @brief Update \p beaconReferenceAngle.
+     * 
+     * @param angle Measured angle of the dezibot
+     * @param direction Direction the dezibot is facing
+     */
+    void setBeaconReference(int angle, ECPDirection direction);
+
+    /**
+     * @brief Get color the given field has on the board.
+     * 
+     * @param field Field on the board
+     * @return FieldColor BLACK_FIELD or WHITE_FIELD
+     */
+    FieldColor getExpectedFieldColor(ECPChessField field);
+
     /**
      * @brief Calculate the time required to rotate based on the angle difference.
      * 
-     * Compute the rotation time needed to adjust the dezibot's angle based on
-     * the difference between the current angle and the target angle.
+     * Compute the rotation time needed to rotate the dezibot by the angle
+     * commanded by \p rotationController.
      *
-     * @param normalizedAngleDifference Difference in angle between the current
-     *            and target positions, in degrees, normalized to [-180, 180].
+     * @param normalizedAngleDifference Angle to rotate in degrees, normalized
+     *            to [-180, 180].
      *
      * @return uint Calculated rotation time (in milliseconds) rounded to the
      *              nearest integer.
      * 
-     * @details The rotation time is derived using a linear relationship.
+     * @details The rotation time is derived using a linear relationship
+     *          fitted online by \p rotationModel.
      * 
      * @see rotateToAngle for how this function is used in the context of
      *      rotating the dezibot to a specific angle.
-     * @see ROTATION_TIME_FACTOR for factor used to define linear relationship.
+     * @see ECPRotationModel for how the linear relationship is fitted.
      */
     uint calculateRotationTime(int normalizedAngleDifference);
 
@@ -248,6 +713,16 @@ private:
      */
     static const int ROTATION_TOLERANCE = 3;
 
+    /**
+     * @brief Duty and rotation in degrees of the spin in
+     *        \p calibrateBearing, slow enough to measure every bin of the
+     *        calibration and a little more than one rotation, so the
+     *        measurements are spread over the whole circle.
+     * 
+     */
+    static const uint CALIBRATION_SPIN_SPEED = 4096;
+    static constexpr float CALIBRATION_SPIN_ANGLE = 370.0f;
+
     /**
      * @brief Maximum iterations for movement used in \p turnLeft, \p turnRight
      *        and \p moveToNextField.
@@ -256,12 +731,96 @@ private:
     static const size_t MAX_ITERATIONS = 10;
 
     /**
-     * @brief Factor used to calculate rotation time.
+     * @brief Maximum attempts to recover from a faulty movement or rotation
+     *        before the user is asked to correct the position.
+     * 
+     */
+    static const size_t RECOVERY_ATTEMPTS = 2;
+
+    /**
+     * @brief Duration in ms and number of short movements used to search a
+     *        field in \p searchFieldColor.
+     * 
+     * Short enough to stay well within one field.
+     * 
+     */
+    static const uint SEARCH_TIME = 150;
+    static const size_t SEARCH_BURSTS = 3;
+
+    /**
+     * @brief Weight of a new measurement when smoothing \p fieldTime.
+     * 
+     */
+    static constexpr float FIELD_TIME_SMOOTHING = 0.3f;
+
+    /**
+     * @brief Range of plausible field times in ms, others are discarded,
+     *        e.g. if the dezibot was blocked.
+     * 
+     */
+    static const uint MIN_FIELD_TIME = 300;
+    static const uint MAX_FIELD_TIME = 5000;
+
+    /**
+     * @brief Distance in fields driven beyond the last edge crossing in
+     *        \p leaveBoard, i.e. from the last field's edge to half a field
+     *        beyond the board.
+     * 
+     */
+    static constexpr float BOARD_EXIT_DISTANCE = 1.5f;
+
+    /**
+     * @brief Maximum number of observations in \p localize.
+     * 
+     */
+    static const size_t LOCALIZATION_STEPS = 12;
+
+    /**
+     * @brief Share of particles that has to agree on a field in \p localize.
+     * 
+     */
+    static constexpr float LOCALIZATION_CONFIDENCE = 0.8f;
+
+    /**
+     * @brief Duration in ms of the movement between two observations in
+     *        \p localize, short enough to stay within one field.
+     * 
+     */
+    static const uint LOCALIZATION_MOVE_TIME = 300;
+
+    /**
+     * @brief Factor used to calculate rotation time until \p rotationModel
+     *        has been fitted.
      * 
      * @see calculateRotationTime for usage.
      * 
      */
     static constexpr float ROTATION_TIME_FACTOR = 25;
+
+    /**
+     * @brief Gains and limits of \p rotationController.
+     * 
+     * With only the proportional gain of 1, the commanded angle equals the
+     * remaining angle difference. The gains are tuned per iteration of
+     * \p rotateToAngle, cf. \p ROTATION_PID_STEP.
+     * 
+     * @see rotateToAngle for usage.
+     */
+    static constexpr PIDConfig ROTATION_PID_CONFIG = {
+        .kp = 1.0f,
+        .ki = 0.1f,
+        .kd = 0.1f,
+        .outputMin = -180.0f,
+        .outputMax = 180.0f,
+        .integralLimit = 20.0f
+    };
+
+    /**
+     * @brief Time step passed to \p rotationController, i.e. one step per
+     *        rotation and measurement.
+     * 
+     */
+    static constexpr float ROTATION_PID_STEP = 1.0f;
 };
 
 #endif // ECPMovement_h
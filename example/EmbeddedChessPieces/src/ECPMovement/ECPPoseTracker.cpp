@@ -0,0 +1,109 @@
+#include "ECPPoseTracker.h"
+
+ECPPoseTracker::ECPPoseTracker(uint referenceDuty)
+    : referenceDuty(referenceDuty),
+      pose({0.0f, 0.0f, 0.0f}) {};
+
+void ECPPoseTracker::begin(Motion &motion) {
+    motion.onTelemetry(handleTelemetry, this);
+};
+
+void ECPPoseTracker::setPose(ECPChessField field, ECPDirection direction) {
+    portENTER_CRITICAL(&lock);
+    pose.x = field.column;
+    pose.y = field.row - 1.0f;
+    pose.heading = direction * 90.0f;
+    portEXIT_CRITICAL(&lock);
+};
+
+void ECPPoseTracker::setPose(ECPPose pose) {
+    pose.heading = std::fmod(pose.heading, 360.0f);
+    if (pose.heading < 0) {
+        pose.heading += 360.0f;
+    }
+
+    portENTER_CRITICAL(&lock);
+    this->pose = pose;
+    portEXIT_CRITICAL(&lock);
+};
+
+void ECPPoseTracker::setHeading(ECPDirection direction) {
+    portENTER_CRITICAL(&lock);
+    pose.heading = direction * 90.0f;
+    portEXIT_CRITICAL(&lock);
+};
+
+void ECPPoseTracker::onFieldBoundaryCrossed() {
+    portENTER_CRITICAL(&lock);
+    const ECPDirection direction = toDirection(pose.heading);
+    // boundaries lie between the field centres, i.e. at k + 0.5
+    const float offset = (direction == NORTH || direction == EAST) ?
+        BOUNDARY_OFFSET : -BOUNDARY_OFFSET;
+    float &coordinate = (direction == NORTH || direction == SOUTH) ?
+        pose.y : pose.x;
+    coordinate = std::floor(coordinate) + 0.5f + offset;
+    portEXIT_CRITICAL(&lock);
+};
+
+ECPPose ECPPoseTracker::getPose() {
+    portENTER_CRITICAL(&lock);
+    const ECPPose currentPose = pose;
+    portEXIT_CRITICAL(&lock);
+    return currentPose;
+};
+
+ECPChessField ECPPoseTracker::getField() {
+    const ECPPose currentPose = getPose();
+    const int column = constrain((int) std::round(currentPose.x), A, H);
+    const int row = constrain((int) std::round(currentPose.y), 0, 7) + 1;
+    return ECPChessField((ECPBoardColumn) column, row);
+};
+
+ECPDirection ECPPoseTracker::getDirection() {
+    return toDirection(getPose().heading);
+};
+
+void ECPPoseTracker::setFieldTime(uint fieldTime) {
+    portENTER_CRITICAL(&lock);
+    this->fieldTime = fieldTime;
+    portEXIT_CRITICAL(&lock);
+};
+
+// -----------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// -----------------------------------------------------------------------------
+
+void ECPPoseTracker::handleTelemetry(
+    const MotionTelemetry &telemetry,
+    void *context
+) {
+    static_cast<ECPPoseTracker*>(context)->update(telemetry);
+};
+
+void ECPPoseTracker::update(const MotionTelemetry &telemetry) {
+    portENTER_CRITICAL(&lock);
+    const float headingChange = telemetry.hasYawRate ?
+        telemetry.yawRate * telemetry.dt : 0.0f;
+
+    // a single running motor only rotates the dezibot, both motors together
+    // move it forward with a speed roughly proportional to the weaker one
+    const uint16_t forwardDuty = std::min(telemetry.leftDuty, telemetry.rightDuty);
+    const float distance = fieldTime > 0 ?
+        forwardDuty / (float) referenceDuty * telemetry.dt * 1000.0f / fieldTime
+        : 0.0f;
+
+    // move along the mean heading of the period
+    const float meanHeading = (pose.heading + headingChange / 2.0f) * DEG_TO_RAD;
+    pose.x += distance * std::sin(meanHeading);
+    pose.y += distance * std::cos(meanHeading);
+
+    pose.heading = std::fmod(pose.heading + headingChange, 360.0f);
+    if (pose.heading < 0) {
+        pose.heading += 360.0f;
+    }
+    portEXIT_CRITICAL(&lock);
+};
+
+ECPDirection ECPPoseTracker::toDirection(float heading) {
+    return (ECPDirection) (((int) std::round(heading / 90.0f)) % 4);
+};
@@ -0,0 +1,184 @@
+/**
+ * @file ECPPoseTracker.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Continuous tracking of the dezibot's pose on the chess board.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPPoseTracker_h
+#define ECPPoseTracker_h
+
+#include <cmath>
+
+#include <Dezibot.h>
+
+#include <ECPChessLogic/ECPChessField.h>
+
+/**
+ * @brief Pose of the dezibot in board coordinates.
+ *
+ * Coordinates are measured in fields, the centre of field A1 is (0, 0) and
+ * the centre of field H8 is (7, 7), i.e. \p x increases towards east and
+ * \p y towards north.
+ *
+ */
+struct ECPPose {
+    float x;
+    float y;
+
+    /**
+     * @brief Heading in degrees within [0, 360), clockwise from north,
+     *        i.e. 90° faces east.
+     *
+     */
+    float heading;
+};
+
+/**
+ * @brief Dead reckoning of the dezibot's pose, corrected by field color
+ *        transitions and absolute headings.
+ *
+ * The tracker is fed by the motor task of \p Motion at its control rate
+ * (cf. \p CONTROL_PERIOD_MS): the heading is integrated from the yaw rate
+ * measured by the gyroscope, the position from the speed expected for the
+ * commanded duties. As this speed is only a rough estimate, callers correct
+ * the position with \p onFieldBoundaryCrossed whenever the field color
+ * changes during a forward movement.
+ *
+ * All methods are safe to call while the motor task updates the pose.
+ *
+ */
+class ECPPoseTracker {
+public:
+    /**
+     * @brief Construct a new pose tracker, initially at the centre of A1
+     *        facing north.
+     *
+     * @param referenceDuty Duty of both motors at which the dezibot needs
+     *                      \p DEFAULT_FIELD_TIME to cross one field, usually
+     *                      the movement calibration
+     */
+    ECPPoseTracker(uint referenceDuty);
+
+    /**
+     * @brief Register at \p Motion to receive its telemetry.
+     *
+     * @attention The tracker must not be moved or copied afterwards, as
+     *            \p Motion keeps a pointer to it.
+     *
+     * @param motion Motion component of the dezibot
+     */
+    void begin(Motion &motion);
+
+    /**
+     * @brief Set pose to the centre of given field facing given direction,
+     *        e.g. after the dezibot was placed on the board.
+     *
+     * @param field Field the dezibot is standing on
+     * @param direction Direction the dezibot is facing
+     */
+    void setPose(ECPChessField field, ECPDirection direction);
+
+    /**
+     * @brief Set pose, e.g. to the result of a localization.
+     *
+     * @param pose New pose, the heading is normalized to [0, 360)
+     */
+    void setPose(ECPPose pose);
+
+    /**
+     * @brief Replace tracked heading by an absolute one, keeping the
+     *        position, e.g. after aligning to a beacon.
+     *
+     * @param direction Direction the dezibot is facing
+     */
+    void setHeading(ECPDirection direction);
+
+    /**
+     * @brief Correct the position after the field color changed.
+     *
+     * The dezibot just crossed the boundary between two fields in driving
+     * direction. The coordinate along the board axis closest to the heading
+     * is therefore set to the nearest boundary, slightly shifted into the new
+     * field by \p BOUNDARY_OFFSET.
+     *
+     */
+    void onFieldBoundaryCrossed();
+
+    /**
+     * @brief Get currently tracked pose.
+     *
+     * @return ECPPose current pose
+     */
+    ECPPose getPose();
+
+    /**
+     * @brief Get field the tracked position lies in, clamped to the board.
+     *
+     * @return ECPChessField current field
+     */
+    ECPChessField getField();
+
+    /**
+     * @brief Get board direction closest to the tracked heading.
+     *
+     * @return ECPDirection current direction
+     */
+    ECPDirection getDirection();
+
+    /**
+     * @brief Set time needed to cross one field with the reference duty.
+     *
+     * @param fieldTime time in ms
+     */
+    void setFieldTime(uint fieldTime);
+
+    /**
+     * @brief Time in ms needed to cross one field with the reference duty
+     *        until \p setFieldTime is called.
+     *
+     */
+    static const uint DEFAULT_FIELD_TIME = 1500;
+
+private:
+    /**
+     * @brief Telemetry callback passed to \p Motion::onTelemetry.
+     *
+     * @param telemetry Telemetry of one control period
+     * @param context Pointer to the \p ECPPoseTracker to update
+     */
+    static void handleTelemetry(const MotionTelemetry &telemetry, void *context);
+
+    /**
+     * @brief Integrate one control period into the pose.
+     *
+     * @param telemetry Telemetry of one control period
+     */
+    void update(const MotionTelemetry &telemetry);
+
+    /**
+     * @brief Round heading to the closest multiple of 90°.
+     *
+     * @param heading Heading in degrees within [0, 360)
+     * @return ECPDirection closest direction
+     */
+    static ECPDirection toDirection(float heading);
+
+    const uint referenceDuty;
+    ECPPose pose;
+    float fieldTime = DEFAULT_FIELD_TIME;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    /**
+     * @brief Distance in fields the dezibot is assumed to be inside the new
+     *        field once the color sensor detects its color.
+     *
+     */
+    static constexpr float BOUNDARY_OFFSET = 0.1f;
+};
+
+#endif // ECPPoseTracker_h
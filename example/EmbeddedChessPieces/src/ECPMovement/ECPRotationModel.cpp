@@ -0,0 +1,130 @@
+#include "ECPRotationModel.h"
+
+ECPRotationModel::ECPRotationModel(float defaultSlope)
+    : defaultSlope(defaultSlope) {
+    setDefaults();
+};
+
+uint ECPRotationModel::predictRotationTime(float angle) {
+    load();
+
+    const float absoluteAngle = std::abs(angle);
+    if (absoluteAngle == 0) {
+        return 0;
+    }
+
+    const float rotationTime = model.intercept + model.slope * absoluteAngle;
+    return rotationTime > 0 ? std::round(rotationTime) : 0;
+};
+
+void ECPRotationModel::addMeasurement(uint rotationTime, float measuredAngle) {
+    load();
+
+    const float x[2] = { 1.0f, std::abs(measuredAngle) };
+    if (x[1] < MIN_FIT_ANGLE) {
+        return;
+    }
+
+    float (&p)[2][2] = model.covariance;
+
+    // gain k = P * x / (lambda + x^T * P * x)
+    const float px[2] = {
+        p[0][0] * x[0] + p[0][1] * x[1],
+        p[1][0] * x[0] + p[1][1] * x[1]
+    };
+    const float denominator = FORGETTING_FACTOR + x[0] * px[0] + x[1] * px[1];
+    const float k[2] = { px[0] / denominator, px[1] / denominator };
+
+    const float error = rotationTime - (model.intercept + model.slope * x[1]);
+    const float intercept = model.intercept + k[0] * error;
+    const float slope = model.slope + k[1] * error;
+
+    if (slope < MIN_SLOPE || MAX_SLOPE < slope) {
+        // implausible measurement, e.g. dezibot was blocked or lifted
+        return;
+    }
+
+    // P = (P - k * x^T * P) / lambda, x^T * P equals (P * x)^T as P is symmetric
+    for (size_t row = 0; row < 2; row++) {
+        for (size_t col = 0; col < 2; col++) {
+            p[row][col] = (p[row][col] - k[row] * px[col]) / FORGETTING_FACTOR;
+        }
+    }
+    p[0][0] = std::min(p[0][0], MAX_VARIANCE);
+    p[1][1] = std::min(p[1][1], MAX_VARIANCE);
+
+    model.intercept = intercept;
+    model.slope = slope;
+    model.measurementCount++;
+    hasChanged = true;
+};
+
+void ECPRotationModel::save() {
+    if (!hasChanged) {
+        return;
+    }
+
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, false);
+    preferences.putBytes(NVS_KEY, &model, sizeof(model));
+    preferences.end();
+    hasChanged = false;
+};
+
+void ECPRotationModel::reset() {
+    setDefaults();
+    isLoaded = true;
+    hasChanged = false;
+
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, false);
+    preferences.remove(NVS_KEY);
+    preferences.end();
+};
+
+float ECPRotationModel::getIntercept() {
+    load();
+    return model.intercept;
+};
+
+float ECPRotationModel::getSlope() {
+    load();
+    return model.slope;
+};
+
+// -----------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// -----------------------------------------------------------------------------
+
+void ECPRotationModel::load() {
+    if (isLoaded) {
+        return;
+    }
+    // NVS is not available during static initialization, hence load lazily
+    isLoaded = true;
+
+    StoredModel storedModel;
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, true);
+    const size_t length = preferences.getBytes(
+        NVS_KEY,
+        &storedModel,
+        sizeof(storedModel)
+    );
+    preferences.end();
+
+    if (length == sizeof(storedModel) && storedModel.version == MODEL_VERSION) {
+        model = storedModel;
+    }
+};
+
+void ECPRotationModel::setDefaults() {
+    model.version = MODEL_VERSION;
+    model.intercept = 0.0f;
+    model.slope = defaultSlope;
+    model.covariance[0][0] = INITIAL_INTERCEPT_VARIANCE;
+    model.covariance[0][1] = 0.0f;
+    model.covariance[1][0] = 0.0f;
+    model.covariance[1][1] = INITIAL_SLOPE_VARIANCE;
+    model.measurementCount = 0;
+};
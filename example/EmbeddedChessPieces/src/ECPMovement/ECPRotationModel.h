@@ -0,0 +1,164 @@
+/**
+ * @file ECPRotationModel.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Self-calibrating model of the dezibot's rotation time.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPRotationModel_h
+#define ECPRotationModel_h
+
+#include <cmath>
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+/**
+ * @brief Linear model <tt>time = intercept + slope * |angle|</tt> mapping a
+ *        rotation angle to the time the motor has to run.
+ *
+ * The coefficients are fitted online with recursive least squares on every
+ * measured rotation and stored in the ESP32's non-volatile storage (NVS).
+ * As the NVS is part of the dezibot's flash, every robot keeps its own model
+ * and starts with it after the next boot.
+ *
+ */
+class ECPRotationModel {
+public:
+    /**
+     * @brief Construct a new rotation model.
+     *
+     * @param defaultSlope Slope in ms per degree used until a model has been
+     *                     fitted or loaded.
+     */
+    ECPRotationModel(float defaultSlope);
+
+    /**
+     * @brief Predict time needed to rotate by given angle.
+     *
+     * Loads the stored model on first usage.
+     *
+     * @param angle Angle to rotate in degrees, sign is ignored.
+     * @return uint Rotation time in ms, 0 for an angle of 0°.
+     */
+    uint predictRotationTime(float angle);
+
+    /**
+     * @brief Add measured rotation to the model.
+     *
+     * Measurements below \p MIN_FIT_ANGLE are ignored as they are dominated
+     * by the uncertainty of the angle measurement.
+     *
+     * @param rotationTime Time the motor was running in ms.
+     * @param measuredAngle Measured rotation in degrees, sign is ignored.
+     */
+    void addMeasurement(uint rotationTime, float measuredAngle);
+
+    /**
+     * @brief Store model in NVS if it changed since it was loaded or stored.
+     *
+     */
+    void save();
+
+    /**
+     * @brief Reset model to the default slope and remove it from NVS.
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Get fitted intercept, i.e. dead time of the rotation, in ms.
+     *
+     * @return float intercept of the model
+     */
+    float getIntercept();
+
+    /**
+     * @brief Get fitted slope in ms per degree.
+     *
+     * @return float slope of the model
+     */
+    float getSlope();
+
+private:
+    /**
+     * @brief Coefficients and covariance of the model as stored in NVS.
+     *
+     */
+    struct StoredModel {
+        uint8_t version;
+        float intercept;
+        float slope;
+        float covariance[2][2];
+        uint32_t measurementCount;
+    };
+
+    /**
+     * @brief Load model from NVS if not done yet.
+     *
+     */
+    void load();
+
+    /**
+     * @brief Initialize coefficients with default values.
+     *
+     */
+    void setDefaults();
+
+    const float defaultSlope;
+    StoredModel model;
+    bool isLoaded = false;
+    bool hasChanged = false;
+
+    /**
+     * @brief Version of \p StoredModel, increase when changing its layout.
+     *
+     */
+    static const uint8_t MODEL_VERSION = 1;
+
+    /**
+     * @brief Forgetting factor of the recursive least squares fit.
+     *
+     * Values below 1 let old measurements fade out, so the model follows
+     * e.g. a draining battery or a different surface.
+     *
+     */
+    static constexpr float FORGETTING_FACTOR = 0.98f;
+
+    /**
+     * @brief Initial covariance, i.e. uncertainty, of intercept and slope.
+     *
+     */
+    static constexpr float INITIAL_INTERCEPT_VARIANCE = 10000.0f;
+    static constexpr float INITIAL_SLOPE_VARIANCE = 10.0f;
+
+    /**
+     * @brief Upper bound of the covariance to avoid it from growing without
+     *        bounds while the measurements contain no new information.
+     *
+     */
+    static constexpr float MAX_VARIANCE = 100000.0f;
+
+    /**
+     * @brief Smallest rotation in degrees that is used to fit the model.
+     *
+     */
+    static constexpr float MIN_FIT_ANGLE = 5.0f;
+
+    /**
+     * @brief Range of plausible slopes in ms per degree. Fits outside of it
+     *        are discarded.
+     *
+     */
+    static constexpr float MIN_SLOPE = 1.0f;
+    static constexpr float MAX_SLOPE = 200.0f;
+
+    static constexpr const char* NVS_NAMESPACE = "ecp-rotation";
+    static constexpr const char* NVS_KEY = "model";
+};
+
+#endif // ECPRotationModel_h
@@ -0,0 +1,46 @@
+#include "ECPSpeedProfile.h"
+
+ECPSpeedProfile::ECPSpeedProfile(uint baseDuty, float cruiseFactor)
+    : baseDuty(baseDuty),
+      cruiseDuty(constrain(baseDuty * cruiseFactor, baseDuty, MAX_DUTY)) {};
+
+uint ECPSpeedProfile::getDuty(uint segment, uint numberOfFields) const {
+    if (segment >= numberOfFields) {
+        return baseDuty;
+    }
+
+    // steps towards the cruise duty after the start and before the goal
+    const uint steps = std::min(
+        std::min(segment, numberOfFields - segment),
+        RAMP_SEGMENTS
+    );
+    return baseDuty + (cruiseDuty - baseDuty) * steps / RAMP_SEGMENTS;
+};
+
+void ECPSpeedProfile::addMeasurement(
+    uint duty,
+    float measuredFieldTime,
+    float baseFieldTime
+) {
+    if (duty <= baseDuty || measuredFieldTime <= 0.0f) {
+        return;
+    }
+
+    const float measuredSpeedup = baseFieldTime / measuredFieldTime;
+    const float expectedSpeedup = duty / (float) baseDuty;
+    const float efficiency =
+        (measuredSpeedup - 1.0f) / (expectedSpeedup - 1.0f);
+    speedupEfficiency += EFFICIENCY_SMOOTHING * (efficiency - speedupEfficiency);
+
+    if (speedupEfficiency < MIN_EFFICIENCY && cruiseDuty > baseDuty) {
+        cruiseDuty = cruiseDuty > baseDuty + CRUISE_DUTY_STEP
+            ? cruiseDuty - CRUISE_DUTY_STEP
+            : baseDuty;
+        // judge the lower duty on its own
+        speedupEfficiency = 1.0f;
+    }
+};
+
+uint ECPSpeedProfile::getCruiseDuty() const {
+    return cruiseDuty;
+};
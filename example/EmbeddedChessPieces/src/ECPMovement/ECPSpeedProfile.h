@@ -0,0 +1,113 @@
+/**
+ * @file ECPSpeedProfile.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Distance-dependent speed profile for forward movements.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPSpeedProfile_h
+#define ECPSpeedProfile_h
+
+#include <Dezibot.h>
+
+/**
+ * @brief Trapezoidal duty profile over the fields of a forward movement.
+ *
+ * A movement over \p n fields consists of <tt>n + 1</tt> segments split by
+ * the edge crossings: from the start to the first edge, between two edges
+ * and from the last edge to the center of the goal. The first and the last
+ * segment always run at the base duty, so the dezibot starts and stops as
+ * calibrated. In between, the duty rises by one step per segment to the
+ * cruise duty and falls again in time before the goal, i.e. short moves
+ * never reach the cruise duty.
+ *
+ * The cruise duty is checked against the measured field times. If a higher
+ * duty does not move the dezibot faster, e.g. because it starts hopping
+ * instead of walking, the cruise duty is lowered.
+ *
+ */
+class ECPSpeedProfile {
+public:
+    /**
+     * @brief Construct a new speed profile.
+     *
+     * @param baseDuty Calibrated duty of the dezibot, cf.
+     *                 \p ECPMovement::movementCalibration
+     * @param cruiseFactor Cruise duty relative to \p baseDuty
+     */
+    ECPSpeedProfile(uint baseDuty, float cruiseFactor = DEFAULT_CRUISE_FACTOR);
+
+    /**
+     * @brief Get duty of a segment of a movement.
+     *
+     * @param segment Number of edges crossed so far
+     * @param numberOfFields Number of fields of the whole movement
+     * @return uint duty of both motors
+     */
+    uint getDuty(uint segment, uint numberOfFields) const;
+
+    /**
+     * @brief Compare measured time to cross one field at a duty above the
+     *        base duty with the time at the base duty and lower the cruise
+     *        duty if it does not pay off.
+     *
+     * @param duty Duty of the measured segment, ignored if not above the
+     *             base duty
+     * @param measuredFieldTime Time between two edge crossings in ms
+     * @param baseFieldTime Estimated time to cross one field at the base
+     *                      duty in ms
+     */
+    void addMeasurement(uint duty, float measuredFieldTime, float baseFieldTime);
+
+    /**
+     * @brief Get current cruise duty.
+     *
+     * @return uint duty in long movements
+     */
+    uint getCruiseDuty() const;
+
+    /**
+     * @brief Default cruise duty relative to the base duty.
+     *
+     */
+    static constexpr float DEFAULT_CRUISE_FACTOR = 1.5f;
+
+    /**
+     * @brief Number of segments to accelerate from the base to the cruise
+     *        duty, and to decelerate again.
+     *
+     */
+    static const uint RAMP_SEGMENTS = 2;
+
+private:
+    const uint baseDuty;
+    uint cruiseDuty;
+
+    /**
+     * @brief Smoothed ratio of the measured speedup to the speedup expected
+     *        from the duty, i.e. 1 if the speed grows linearly with the duty.
+     *
+     */
+    float speedupEfficiency = 1.0f;
+
+    /**
+     * @brief Weight of a new measurement when smoothing
+     *        \p speedupEfficiency.
+     *
+     */
+    static constexpr float EFFICIENCY_SMOOTHING = 0.3f;
+
+    /**
+     * @brief Efficiency below which the cruise duty is lowered by
+     *        \p CRUISE_DUTY_STEP.
+     *
+     */
+    static constexpr float MIN_EFFICIENCY = 0.5f;
+    static const uint CRUISE_DUTY_STEP = 300;
+};
+
+#endif // ECPSpeedProfile_h
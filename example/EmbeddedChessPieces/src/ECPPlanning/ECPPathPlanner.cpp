@@ -0,0 +1,194 @@
+#include "ECPPathPlanner.h"
+
+ECPPathPlanner::ECPPathPlanner(ECPReservationTable &table) : table(table) {};
+
+bool ECPPathPlanner::plan(
+    uint8_t robotId,
+    ECPChessField from,
+    ECPChessField to,
+    size_t startSlot,
+    ECPPlannedPath &path
+) {
+    return search(
+        robotId, from.toIndex(), 1ULL << to.toIndex(), startSlot, path
+    );
+};
+
+size_t ECPPathPlanner::planMoves(
+    const ECPMoveRequest *requests,
+    size_t count,
+    ECPPlannedPath *paths
+) {
+    if (MAX_MOVES < count) {
+        count = MAX_MOVES;
+    }
+
+    // every dezibot starts parked on its start field
+    bool done[MAX_MOVES];
+    bool parked[MAX_MOVES];
+    for (size_t i = 0; i < count; i++) {
+        done[i] = false;
+        parked[i] = false;
+        paths[i].robotId = requests[i].robotId;
+        paths[i].startSlot = 0;
+        paths[i].length = 1;
+        paths[i].fields[0] = requests[i].from.toIndex();
+        table.reserveFrom(requests[i].from, 0, requests[i].robotId);
+    }
+
+    size_t planned = 0;
+    while (planned < count) {
+        bool progress = false;
+        for (size_t i = 0; i < count; i++) {
+            if (!done[i]
+                    && extendPath(paths[i], 1ULL << requests[i].to.toIndex())) {
+                done[i] = true;
+                planned++;
+                progress = true;
+            }
+        }
+        if (progress) {
+            continue;
+        }
+
+        // goals of the remaining moves are blocked by each other
+        uint64_t blockedGoals = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!done[i]) {
+                blockedGoals |= 1ULL << requests[i].to.toIndex();
+                blockedGoals |= 1ULL << paths[i].fields[paths[i].length - 1];
+            }
+        }
+        for (size_t i = 0; i < count && !progress; i++) {
+            if (!done[i] && !parked[i]) {
+                parked[i] = true;
+                progress = extendPath(paths[i], ~blockedGoals);
+            }
+        }
+        if (!progress) {
+            break;
+        }
+    }
+    return planned;
+};
+
+
+// ----- PRIVATE FUNCTIONS -----
+
+bool ECPPathPlanner::search(
+    uint8_t robotId,
+    uint8_t start,
+    uint64_t goals,
+    size_t startSlot,
+    ECPPlannedPath &path
+) {
+    const size_t slots = ECPReservationTable::TIME_SLOTS;
+
+    path.robotId = robotId;
+    path.startSlot = startSlot;
+    path.length = 0;
+
+    if (slots <= startSlot || !table.isFree(start, startSlot, robotId)) {
+        return false;
+    }
+
+    memset(parents, UNVISITED, sizeof(parents));
+    size_t head = 0;
+    size_t tail = 0;
+    parents[startSlot][start] = start;
+    queue[tail++] = startSlot * 64 + start;
+
+    while (head < tail) {
+        const size_t slot = queue[head] / 64;
+        const uint8_t fieldIndex = queue[head] % 64;
+        head++;
+
+        if ((goals >> fieldIndex & 1)
+                && isFreeFrom(fieldIndex, slot, robotId)) {
+            // follow parents back to the start
+            path.length = slot - startSlot + 1;
+            uint8_t current = fieldIndex;
+            for (size_t i = path.length; i > 0; i--) {
+                path.fields[i - 1] = current;
+                current = parents[startSlot + i - 1][current];
+            }
+            return true;
+        }
+
+        const size_t nextSlot = slot + 1;
+        if (slots <= nextSlot) {
+            continue;
+        }
+
+        // waiting first, so equally fast paths prefer fewer movements
+        for (int8_t direction = -1; direction < 4; direction++) {
+            const int next = direction == -1
+                ? fieldIndex
+                : getNeighbor(fieldIndex, direction);
+            if (next == -1 || parents[nextSlot][next] != UNVISITED) {
+                continue;
+            }
+            if (!table.isFree(next, nextSlot, robotId)) {
+                continue;
+            }
+            // the dezibot still occupies its field while moving away
+            if (next != fieldIndex
+                    && !table.isFree(fieldIndex, nextSlot, robotId)) {
+                continue;
+            }
+            parents[nextSlot][next] = fieldIndex;
+            queue[tail++] = nextSlot * 64 + next;
+        }
+    }
+
+    return false;
+};
+
+bool ECPPathPlanner::extendPath(ECPPlannedPath &path, uint64_t goals) {
+    // the new leg may use the fields the dezibot reserved for parking
+    table.release(path.robotId);
+
+    ECPPlannedPath leg;
+    const size_t lastSlot = path.startSlot + path.length - 1;
+    const uint8_t current = path.fields[path.length - 1];
+    if (!search(path.robotId, current, goals, lastSlot, leg)) {
+        table.reservePath(path);
+        return false;
+    }
+
+    for (size_t i = 1; i < leg.length; i++) {
+        path.fields[path.length++] = leg.fields[i];
+    }
+    table.reservePath(path);
+    return true;
+};
+
+bool ECPPathPlanner::isFreeFrom(
+    uint8_t fieldIndex,
+    size_t slot,
+    uint8_t robotId
+) const {
+    for (; slot < ECPReservationTable::TIME_SLOTS; slot++) {
+        if (!table.isFree(fieldIndex, slot, robotId)) {
+            return false;
+        }
+    }
+    return true;
+};
+
+int ECPPathPlanner::getNeighbor(uint8_t fieldIndex, uint8_t direction) {
+    const uint8_t column = fieldIndex % 8;
+    const uint8_t row = fieldIndex / 8;
+    switch (direction) {
+        case 0:
+            return row < 7 ? fieldIndex + 8 : -1;
+        case 1:
+            return column < 7 ? fieldIndex + 1 : -1;
+        case 2:
+            return row > 0 ? fieldIndex - 8 : -1;
+        case 3:
+            return column > 0 ? fieldIndex - 1 : -1;
+        default:
+            return -1;
+    }
+};
@@ -0,0 +1,167 @@
+/**
+ * @file ECPPathPlanner.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Collision-free path planning for multiple dezibots.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPPathPlanner_h
+#define ECPPathPlanner_h
+
+#include <Arduino.h>
+
+#include <ECPChessLogic/ECPChessField.h>
+
+#include "ECPPlannedPath.h"
+#include "ECPReservationTable.h"
+
+/**
+ * @brief Move of one dezibot to be planned by \p ECPPathPlanner.
+ *
+ */
+struct ECPMoveRequest {
+    uint8_t robotId;
+    ECPChessField from;
+    ECPChessField to;
+};
+
+/**
+ * @brief Plans paths through space and time, avoiding all fields reserved by
+ *        other dezibots.
+ *
+ * Dezibots only drive between orthogonally neighboring fields, so knight
+ * moves and blocked straight moves are routed around occupied fields. In
+ * every slot, a dezibot either waits or moves to a neighboring field. Paths
+ * are planned one after another, each path respecting the reservations of
+ * the paths planned before (prioritized planning), so independent moves run
+ * in the same slots.
+ *
+ */
+class ECPPathPlanner {
+public:
+    /**
+     * @brief Construct a new planner working on a reservation table.
+     *
+     * @param table Reservations of all dezibots, planned paths are added
+     */
+    ECPPathPlanner(ECPReservationTable &table);
+
+    /**
+     * @brief Plan shortest path in time from \p from to \p to, starting at
+     *        \p startSlot, without reserving it.
+     *
+     * The goal has to stay free after arrival, since the dezibot remains on
+     * it.
+     *
+     * @param robotId Id of the dezibot
+     * @param from Current field of the dezibot
+     * @param to Goal field
+     * @param startSlot Slot in which the dezibot is on \p from
+     * @param path Set to the planned path
+     * @return true if a path within the horizon exists, false otherwise
+     */
+    bool plan(
+        uint8_t robotId,
+        ECPChessField from,
+        ECPChessField to,
+        size_t startSlot,
+        ECPPlannedPath &path
+    );
+
+    /**
+     * @brief Plan and reserve paths of multiple dezibots starting in slot 0,
+     *        e.g. to set up the initial position.
+     *
+     * The start fields of all dezibots are reserved first, so no path leads
+     * through a dezibot which has not moved yet. Moves are planned in the
+     * given order, i.e. earlier moves have priority. A move whose goal is
+     * still occupied is retried after the other moves. If dezibots block
+     * each other in a cycle, e.g. when swapping fields, one of them first
+     * drives to a free field and continues from there. If a move cannot be
+     * planned at all, its dezibot stays on its start field.
+     *
+     * @param requests Moves to plan
+     * @param count Number of moves, at most \p MAX_MOVES are planned
+     * @param paths Set to the path of each move, in the order of \p requests
+     * @return size_t number of moves that could be planned
+     */
+    size_t planMoves(
+        const ECPMoveRequest *requests,
+        size_t count,
+        ECPPlannedPath *paths
+    );
+
+    /**
+     * @brief Maximum number of moves planned together, i.e. all pieces.
+     *
+     */
+    static const size_t MAX_MOVES = 32;
+
+private:
+    /**
+     * @brief Breadth-first search through space and time to the first
+     *        reachable field of \p goals that stays free after arrival.
+     *
+     * @param goals Bit mask of accepted goal field indices
+     */
+    bool search(
+        uint8_t robotId,
+        uint8_t start,
+        uint64_t goals,
+        size_t startSlot,
+        ECPPlannedPath &path
+    );
+
+    /**
+     * @brief Continue \p path of an unfinished move with a new leg and
+     *        reserve the combined path.
+     *
+     * @param goals Bit mask of accepted goal field indices
+     * @return true if the leg could be planned, otherwise the reservations
+     *         of \p path are restored
+     */
+    bool extendPath(ECPPlannedPath &path, uint64_t goals);
+
+    /**
+     * @brief Check whether a dezibot may stay on a field from given slot
+     *        to the end of the horizon.
+     *
+     */
+    bool isFreeFrom(uint8_t fieldIndex, size_t slot, uint8_t robotId) const;
+
+    /**
+     * @brief Get index of the neighboring field in a direction.
+     *
+     * @param fieldIndex Index of the field
+     * @param direction 0 north, 1 east, 2 south, 3 west
+     * @return int index of the neighbor, -1 if outside of the board
+     */
+    static int getNeighbor(uint8_t fieldIndex, uint8_t direction);
+
+    ECPReservationTable &table;
+
+    /**
+     * @brief Marker for unvisited states in \p parents.
+     *
+     */
+    static const uint8_t UNVISITED = 0xFF;
+
+    /**
+     * @brief Field index of the predecessor per slot and field index.
+     *
+     */
+    uint8_t parents[ECPReservationTable::TIME_SLOTS][64];
+
+    /**
+     * @brief Breadth-first queue of states encoded as
+     *        <tt>slot * 64 + fieldIndex</tt>.
+     *
+     */
+    uint16_t queue[ECPReservationTable::TIME_SLOTS * 64];
+};
+
+#endif // ECPPathPlanner_h
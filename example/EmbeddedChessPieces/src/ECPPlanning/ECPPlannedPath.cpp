@@ -0,0 +1,65 @@
+#include "ECPPlannedPath.h"
+
+ECPChessField ECPPlannedPath::getField(size_t i) const {
+    return ECPChessField::fromIndex(fields[i]);
+};
+
+ECPChessField ECPPlannedPath::getGoal() const {
+    return getField(length - 1);
+};
+
+String ECPPlannedPath::toMessage(uint32_t epoch, uint32_t slotDuration) const {
+    String message = "PATH;" + String(robotId) + ";" + String(epoch) + ";"
+        + String(slotDuration) + ";" + String(startSlot) + ";";
+    for (size_t i = 0; i < length; i++) {
+        if (i > 0) {
+            message += ",";
+        }
+        message += String(fields[i]);
+    }
+    return message;
+};
+
+bool ECPPlannedPath::fromMessage(
+    const String &message,
+    ECPPlannedPath &path,
+    uint32_t &epoch,
+    uint32_t &slotDuration
+) {
+    if (!message.startsWith("PATH;")) {
+        return false;
+    }
+
+    // header values separated by ';', followed by the field indices
+    long values[4];
+    int start = 5;
+    for (size_t i = 0; i < 4; i++) {
+        const int end = message.indexOf(';', start);
+        if (end == -1) {
+            return false;
+        }
+        values[i] = message.substring(start, end).toInt();
+        start = end + 1;
+    }
+
+    path.robotId = values[0];
+    epoch = values[1];
+    slotDuration = values[2];
+    path.startSlot = values[3];
+    path.length = 0;
+
+    while (start < (int) message.length() && path.length < MAX_LENGTH) {
+        int end = message.indexOf(',', start);
+        if (end == -1) {
+            end = message.length();
+        }
+        const long index = message.substring(start, end).toInt();
+        if (index < 0 || 63 < index) {
+            return false;
+        }
+        path.fields[path.length++] = index;
+        start = end + 1;
+    }
+
+    return path.length > 0;
+};
@@ -0,0 +1,87 @@
+/**
+ * @file ECPPlannedPath.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Space-time path of one dezibot on the chess board.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPPlannedPath_h
+#define ECPPlannedPath_h
+
+#include <Arduino.h>
+
+#include <ECPChessLogic/ECPChessField.h>
+
+/**
+ * @brief Fields a dezibot occupies in consecutive time slots.
+ *
+ * Entry \p i is the field occupied in slot <tt>startSlot + i</tt>. If two
+ * consecutive entries differ, the dezibot moves between the fields during
+ * the later slot and occupies both of them. Equal consecutive entries mean
+ * waiting. After the last slot, the dezibot stays on the last field.
+ *
+ */
+struct ECPPlannedPath {
+    /**
+     * @brief Maximum number of slots of a path, i.e. the planning horizon.
+     *
+     */
+    static const size_t MAX_LENGTH = 64;
+
+    uint8_t robotId = 0;
+    size_t startSlot = 0;
+    size_t length = 0;
+
+    /**
+     * @brief Field indices, see \p ECPChessField::toIndex.
+     *
+     */
+    uint8_t fields[MAX_LENGTH];
+
+    /**
+     * @brief Get field occupied in slot <tt>startSlot + i</tt>.
+     *
+     * @param i Index in [0, length)
+     * @return ECPChessField field of the slot
+     */
+    ECPChessField getField(size_t i) const;
+
+    /**
+     * @brief Get last field of the path.
+     *
+     * @return ECPChessField goal of the path
+     */
+    ECPChessField getGoal() const;
+
+    /**
+     * @brief Serialize path to send it via \p Communication, e.g.
+     *        <tt>PATH;3;120500;8000;2;8,9,17</tt>.
+     *
+     * @param epoch Mesh time in ms at which slot 0 starts
+     * @param slotDuration Duration of one slot in ms
+     * @return String message
+     */
+    String toMessage(uint32_t epoch, uint32_t slotDuration) const;
+
+    /**
+     * @brief Parse message created by \p toMessage.
+     *
+     * @param message Received message
+     * @param path Set to the parsed path
+     * @param epoch Set to the mesh time in ms at which slot 0 starts
+     * @param slotDuration Set to the duration of one slot in ms
+     * @return true if the message contained a valid path, false otherwise
+     */
+    static bool fromMessage(
+        const String &message,
+        ECPPlannedPath &path,
+        uint32_t &epoch,
+        uint32_t &slotDuration
+    );
+};
+
+#endif // ECPPlannedPath_h
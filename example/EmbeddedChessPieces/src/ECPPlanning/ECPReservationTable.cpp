@@ -0,0 +1,90 @@
+#include "ECPReservationTable.h"
+
+ECPReservationTable::ECPReservationTable() {
+    clear();
+};
+
+void ECPReservationTable::clear() {
+    memset(reservations, FREE, sizeof(reservations));
+};
+
+bool ECPReservationTable::reserveFrom(
+    ECPChessField field,
+    size_t firstSlot,
+    uint8_t robotId
+) {
+    const uint8_t fieldIndex = field.toIndex();
+    firstSlot = std::min(firstSlot, TIME_SLOTS - 1);
+    for (size_t slot = firstSlot; slot < TIME_SLOTS; slot++) {
+        if (!isFree(fieldIndex, slot, robotId)) {
+            return false;
+        }
+    }
+
+    for (size_t slot = firstSlot; slot < TIME_SLOTS; slot++) {
+        reservations[slot][fieldIndex] = robotId;
+    }
+    return true;
+};
+
+bool ECPReservationTable::reservePath(const ECPPlannedPath &path) {
+    if (path.length == 0 || TIME_SLOTS < path.startSlot + path.length) {
+        return false;
+    }
+
+    // check first, so a conflicting path does not leave partial reservations
+    for (size_t i = 0; i < path.length; i++) {
+        const size_t slot = path.startSlot + i;
+        if (!isFree(path.fields[i], slot, path.robotId)) {
+            return false;
+        }
+        // the dezibot still occupies the previous field while moving
+        if (i > 0 && !isFree(path.fields[i - 1], slot, path.robotId)) {
+            return false;
+        }
+    }
+    const size_t lastSlot = path.startSlot + path.length - 1;
+    for (size_t slot = lastSlot; slot < TIME_SLOTS; slot++) {
+        if (!isFree(path.fields[path.length - 1], slot, path.robotId)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < path.length; i++) {
+        const size_t slot = path.startSlot + i;
+        reservations[slot][path.fields[i]] = path.robotId;
+        if (i > 0) {
+            reservations[slot][path.fields[i - 1]] = path.robotId;
+        }
+    }
+    for (size_t slot = lastSlot; slot < TIME_SLOTS; slot++) {
+        reservations[slot][path.fields[path.length - 1]] = path.robotId;
+    }
+    return true;
+};
+
+void ECPReservationTable::release(uint8_t robotId) {
+    for (size_t slot = 0; slot < TIME_SLOTS; slot++) {
+        for (size_t fieldIndex = 0; fieldIndex < 64; fieldIndex++) {
+            if (reservations[slot][fieldIndex] == robotId) {
+                reservations[slot][fieldIndex] = FREE;
+            }
+        }
+    }
+};
+
+uint8_t ECPReservationTable::getReservation(
+    uint8_t fieldIndex,
+    size_t slot
+) const {
+    return reservations[std::min(slot, TIME_SLOTS - 1)][fieldIndex];
+};
+
+bool ECPReservationTable::isFree(
+    uint8_t fieldIndex,
+    size_t slot,
+    uint8_t robotId
+) const {
+    const uint8_t reservation = getReservation(fieldIndex, slot);
+    return reservation == FREE || reservation == robotId;
+};
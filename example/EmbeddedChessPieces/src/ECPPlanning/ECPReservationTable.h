@@ -0,0 +1,112 @@
+/**
+ * @file ECPReservationTable.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Reservations of fields in time slots for multiple dezibots.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPReservationTable_h
+#define ECPReservationTable_h
+
+#include <Arduino.h>
+
+#include <ECPChessLogic/ECPChessField.h>
+
+#include "ECPPlannedPath.h"
+
+/**
+ * @brief Table of which dezibot may occupy which field in which time slot.
+ *
+ * Slots are counted from the start of a plan, a slot has to be long enough
+ * for a dezibot to turn and move to a neighboring field. Slots beyond the
+ * planning horizon are treated like the last slot, i.e. a dezibot reserving
+ * the last slot of a field stays there.
+ *
+ */
+class ECPReservationTable {
+public:
+    /**
+     * @brief Number of time slots of the table.
+     *
+     */
+    static const size_t TIME_SLOTS = ECPPlannedPath::MAX_LENGTH;
+
+    /**
+     * @brief Robot id of a free field. Robot ids start at 1.
+     *
+     */
+    static const uint8_t FREE = 0;
+
+    /**
+     * @brief Construct a new empty table.
+     *
+     */
+    ECPReservationTable();
+
+    /**
+     * @brief Remove all reservations.
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Reserve field from given slot to the end of the horizon, e.g.
+     *        for a dezibot standing on the field.
+     *
+     * @param field Field to reserve
+     * @param firstSlot First slot to reserve
+     * @param robotId Id of the dezibot
+     * @return true if all slots were free or already reserved by the
+     *         dezibot, false otherwise. Nothing is reserved in that case.
+     */
+    bool reserveFrom(ECPChessField field, size_t firstSlot, uint8_t robotId);
+
+    /**
+     * @brief Reserve all fields of a path, including both fields during a
+     *        movement and the goal until the end of the horizon.
+     *
+     * @param path Path planned by \p ECPPathPlanner
+     * @return true if all fields were free or already reserved by the
+     *         dezibot, false otherwise. Nothing is reserved in that case.
+     */
+    bool reservePath(const ECPPlannedPath &path);
+
+    /**
+     * @brief Remove all reservations of a dezibot.
+     *
+     * @param robotId Id of the dezibot
+     */
+    void release(uint8_t robotId);
+
+    /**
+     * @brief Get id of the dezibot that reserved a field in a slot.
+     *
+     * @param fieldIndex Index of the field, see \p ECPChessField::toIndex
+     * @param slot Slot, slots beyond the horizon return the last slot
+     * @return uint8_t robot id or \p FREE
+     */
+    uint8_t getReservation(uint8_t fieldIndex, size_t slot) const;
+
+    /**
+     * @brief Check whether a dezibot may occupy a field in a slot.
+     *
+     * @param fieldIndex Index of the field, see \p ECPChessField::toIndex
+     * @param slot Slot, slots beyond the horizon return the last slot
+     * @param robotId Id of the dezibot
+     * @return true if the field is free or reserved by the dezibot
+     */
+    bool isFree(uint8_t fieldIndex, size_t slot, uint8_t robotId) const;
+
+private:
+    /**
+     * @brief Robot ids per slot and field index.
+     *
+     */
+    uint8_t reservations[TIME_SLOTS][64];
+};
+
+#endif // ECPReservationTable_h
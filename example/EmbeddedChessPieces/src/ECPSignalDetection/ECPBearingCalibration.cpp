@@ -0,0 +1,232 @@
+#include "ECPBearingCalibration.h"
+#include "ECPSignalDetection.h"
+
+float ECPBearingCalibration::getBearing(const IRMeasurements &measurements) {
+    float response[4] = {
+        measurements.north,
+        measurements.east,
+        measurements.south,
+        measurements.west
+    };
+    if (!isCalibrated() || !normalizeResponse(response)) {
+        return std::atan2(
+            measurements.east - measurements.west,
+            measurements.north - measurements.south
+        ) * RAD_TO_DEG;
+    }
+
+    size_t closestBin = 0;
+    float closestDistance = getDistance(response, 0);
+    for (size_t bin = 1; bin < BIN_COUNT; bin++) {
+        const float distance = getDistance(response, bin);
+        if (distance < closestDistance) {
+            closestBin = bin;
+            closestDistance = distance;
+        }
+    }
+
+    // vertex of the parabola through the distances of the neighboring bins
+    const float before =
+        getDistance(response, (closestBin + BIN_COUNT - 1) % BIN_COUNT);
+    const float after = getDistance(response, (closestBin + 1) % BIN_COUNT);
+    const float curvature = before - 2 * closestDistance + after;
+    float offset = 0.0f;
+    if (curvature > 0.0f) {
+        offset = constrain(0.5f * (before - after) / curvature, -0.5f, 0.5f);
+    }
+
+    // bins start at -180°
+    return normalizeAngle((closestBin + 0.5f + offset) * BIN_WIDTH - 180.0f);
+};
+
+bool ECPBearingCalibration::isCalibrated() {
+    load();
+    return hasCalibration;
+};
+
+void ECPBearingCalibration::beginSpin() {
+    spinSampleCount = 0;
+};
+
+bool ECPBearingCalibration::addSpinSample(
+    const IRMeasurements &measurements,
+    float heading
+) {
+    if (spinSampleCount == MAX_SPIN_SAMPLES || !measurements.hasSignal()) {
+        return false;
+    }
+
+    SpinSample &sample = spinSamples[spinSampleCount++];
+    sample.values[0] = measurements.north;
+    sample.values[1] = measurements.east;
+    sample.values[2] = measurements.south;
+    sample.values[3] = measurements.west;
+    sample.heading = heading;
+    return true;
+};
+
+bool ECPBearingCalibration::finishSpin() {
+    if (spinSampleCount < 2) {
+        return false;
+    }
+    const float firstHeading = spinSamples[0].heading;
+    const float spinAngle = spinSamples[spinSampleCount - 1].heading - firstHeading;
+    if (spinAngle < MIN_SPIN_ANGLE) {
+        return false;
+    }
+
+    // the true bearing is offset - heading with the direction of the beacon
+    // as unknown offset. Each sensor responds symmetrically around its
+    // direction, so the offset is the mean of the headings plus the
+    // sensor's direction, weighted by its measurements.
+    float offsetSin = 0.0f;
+    float offsetCos = 0.0f;
+    for (size_t i = 0; i < spinSampleCount; i++) {
+        for (size_t sensor = 0; sensor < 4; sensor++) {
+            const float offset =
+                (spinSamples[i].heading + sensor * 90.0f) * DEG_TO_RAD;
+            offsetSin += spinSamples[i].values[sensor] * std::sin(offset);
+            offsetCos += spinSamples[i].values[sensor] * std::cos(offset);
+        }
+    }
+    const float offset = std::atan2(offsetSin, offsetCos) * RAD_TO_DEG;
+
+    // mean normalized response per bin of the true bearing
+    StoredCalibration fitted = {};
+    fitted.version = CALIBRATION_VERSION;
+    size_t counts[BIN_COUNT] = {};
+    for (size_t i = 0; i < spinSampleCount; i++) {
+        float response[4];
+        memcpy(response, spinSamples[i].values, sizeof(response));
+        if (!normalizeResponse(response)) {
+            continue;
+        }
+        const float bearing = normalizeAngle(offset - spinSamples[i].heading);
+        const size_t bin = std::min(
+            (size_t) ((bearing + 180.0f) / BIN_WIDTH),
+            BIN_COUNT - 1
+        );
+        for (size_t sensor = 0; sensor < 4; sensor++) {
+            fitted.responses[bin][sensor] += response[sensor];
+        }
+        counts[bin]++;
+    }
+
+    size_t filledBins = 0;
+    for (size_t bin = 0; bin < BIN_COUNT; bin++) {
+        if (counts[bin] > 0) {
+            for (size_t sensor = 0; sensor < 4; sensor++) {
+                fitted.responses[bin][sensor] /= counts[bin];
+            }
+            filledBins++;
+        }
+    }
+    if (filledBins == 0) {
+        return false;
+    }
+
+    // interpolate empty bins between the closest filled bins on both sides
+    for (size_t bin = 0; bin < BIN_COUNT; bin++) {
+        if (counts[bin] > 0) {
+            continue;
+        }
+        size_t before = 1;
+        while (counts[(bin + BIN_COUNT - before) % BIN_COUNT] == 0) {
+            before++;
+        }
+        size_t after = 1;
+        while (counts[(bin + after) % BIN_COUNT] == 0) {
+            after++;
+        }
+        const float *lowerResponse =
+            fitted.responses[(bin + BIN_COUNT - before) % BIN_COUNT];
+        const float *upperResponse =
+            fitted.responses[(bin + after) % BIN_COUNT];
+        for (size_t sensor = 0; sensor < 4; sensor++) {
+            fitted.responses[bin][sensor] = lowerResponse[sensor]
+                + (upperResponse[sensor] - lowerResponse[sensor])
+                * before / (before + after);
+        }
+    }
+
+    calibration = fitted;
+    isLoaded = true;
+    hasCalibration = true;
+
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, false);
+    preferences.putBytes(NVS_KEY, &calibration, sizeof(calibration));
+    preferences.end();
+    return true;
+};
+
+void ECPBearingCalibration::reset() {
+    isLoaded = true;
+    hasCalibration = false;
+
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, false);
+    preferences.remove(NVS_KEY);
+    preferences.end();
+};
+
+// -----------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// -----------------------------------------------------------------------------
+
+void ECPBearingCalibration::load() {
+    if (isLoaded) {
+        return;
+    }
+    // NVS is not available during static initialization, hence load lazily
+    isLoaded = true;
+
+    StoredCalibration storedCalibration;
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE, true);
+    const size_t length = preferences.getBytes(
+        NVS_KEY,
+        &storedCalibration,
+        sizeof(storedCalibration)
+    );
+    preferences.end();
+
+    if (length == sizeof(storedCalibration)
+            && storedCalibration.version == CALIBRATION_VERSION) {
+        calibration = storedCalibration;
+        hasCalibration = true;
+    }
+};
+
+bool ECPBearingCalibration::normalizeResponse(float *values) {
+    const float sum = values[0] + values[1] + values[2] + values[3];
+    if (sum <= 0.0f) {
+        return false;
+    }
+    for (size_t sensor = 0; sensor < 4; sensor++) {
+        values[sensor] /= sum;
+    }
+    return true;
+};
+
+float ECPBearingCalibration::getDistance(
+    const float *response,
+    size_t bin
+) const {
+    float distance = 0.0f;
+    for (size_t sensor = 0; sensor < 4; sensor++) {
+        const float difference = response[sensor] - calibration.responses[bin][sensor];
+        distance += difference * difference;
+    }
+    return distance;
+};
+
+float ECPBearingCalibration::normalizeAngle(float angle) {
+    angle = std::fmod(angle, 360.0f);
+    if (angle <= -180.0f) {
+        angle += 360.0f;
+    } else if (angle > 180.0f) {
+        angle -= 360.0f;
+    }
+    return angle;
+};
@@ -0,0 +1,182 @@
+/**
+ * @file ECPBearingCalibration.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Per-robot calibration of the beacon bearing.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ECPBearingCalibration_h
+#define ECPBearingCalibration_h
+
+#include <cmath>
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+struct IRMeasurements;
+
+/**
+ * @brief Lookup table mapping the four lateral infrared measurements to the
+ *        bearing of the beacon.
+ *
+ * The plain bearing <tt>atan2(east - west, north - south)</tt> assumes four
+ * identical sensors with an ideal cosine response. Real phototransistors
+ * differ in sensitivity and their response is narrower, so the plain
+ * bearing is pulled towards the closest sensor. Instead, the table stores
+ * the measured response of all four sensors, normalized to a sum of 1, for
+ * every \p BIN_WIDTH degrees of bearing. A measurement is mapped to the
+ * bin with the closest response and refined by a parabola through the
+ * distances to the neighboring bins.
+ *
+ * The table is filled from measurements taken during one full spin of the
+ * dezibot, using the heading integrated from the gyroscope as ground truth
+ * (cf. \p ECPMovement::calibrateBearing). Like \p ECPRotationModel, the
+ * calibration is stored in the ESP32's non-volatile storage (NVS), so every
+ * robot keeps its own.
+ *
+ */
+class ECPBearingCalibration {
+public:
+    /**
+     * @brief Get bearing of the beacon clockwise from the dezibot's front.
+     *
+     * Loads the stored calibration on first usage. Without a calibration,
+     * the plain bearing is returned.
+     *
+     * @param measurements Measurements of the beacon, cf.
+     *        \p ECPSignalDetection::measureIR
+     * @return float bearing in degrees, i.e. (-180, 180]
+     */
+    float getBearing(const IRMeasurements &measurements);
+
+    /**
+     * @brief Check whether a calibration was fitted or loaded.
+     *
+     * @return true if \p getBearing applies a calibration
+     */
+    bool isCalibrated();
+
+    /**
+     * @brief Discard measurements of a previous spin.
+     *
+     */
+    void beginSpin();
+
+    /**
+     * @brief Add measurement taken during the spin.
+     *
+     * Measurements without signal and measurements beyond
+     * \p MAX_SPIN_SAMPLES are ignored.
+     *
+     * @param measurements Measurements of the beacon
+     * @param heading Heading of the dezibot in degrees, integrated from the
+     *        gyroscope and unwrapped, i.e. increasing beyond 360° while
+     *        rotating clockwise
+     * @return true if the measurement was added
+     */
+    bool addSpinSample(const IRMeasurements &measurements, float heading);
+
+    /**
+     * @brief Fit calibration to the measurements of the spin and store it
+     *        in NVS.
+     *
+     * @return true if the spin covered a full rotation, false otherwise.
+     *         The previous calibration is kept in that case.
+     */
+    bool finishSpin();
+
+    /**
+     * @brief Remove calibration, also from NVS.
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Width of a bin of the correction table in degrees.
+     *
+     */
+    static const size_t BIN_WIDTH = 5;
+
+    /**
+     * @brief Maximum number of measurements of one spin.
+     *
+     */
+    static const size_t MAX_SPIN_SAMPLES = 128;
+
+private:
+    /**
+     * @brief Number of bins of the correction table.
+     *
+     */
+    static const size_t BIN_COUNT = 360 / BIN_WIDTH;
+
+    /**
+     * @brief Calibration as stored in NVS.
+     *
+     */
+    struct StoredCalibration {
+        uint8_t version;
+        float responses[BIN_COUNT][4];
+    };
+
+    struct SpinSample {
+        float values[4];
+        float heading;
+    };
+
+    /**
+     * @brief Load calibration from NVS if not done yet.
+     *
+     */
+    void load();
+
+    /**
+     * @brief Normalize measurements to a sum of 1.
+     *
+     * @param values North, east, south and west measurement, normalized in
+     *        place
+     * @return false if the sum is not positive
+     */
+    static bool normalizeResponse(float *values);
+
+    /**
+     * @brief Get squared distance of a normalized response to a bin.
+     *
+     */
+    float getDistance(const float *response, size_t bin) const;
+
+    /**
+     * @brief Normalize angle to (-180, 180].
+     *
+     */
+    static float normalizeAngle(float angle);
+
+    StoredCalibration calibration;
+    bool isLoaded = false;
+    bool hasCalibration = false;
+
+    SpinSample spinSamples[MAX_SPIN_SAMPLES];
+    size_t spinSampleCount = 0;
+
+    /**
+     * @brief Version of \p StoredCalibration, increase when changing its
+     *        layout.
+     *
+     */
+    static const uint8_t CALIBRATION_VERSION = 1;
+
+    /**
+     * @brief Minimum rotation in degrees covered by a spin.
+     *
+     */
+    static constexpr float MIN_SPIN_ANGLE = 360.0f;
+
+    static constexpr const char* NVS_NAMESPACE = "ecp-bearing";
+    static constexpr const char* NVS_KEY = "calibration";
+};
+
+#endif // ECPBearingCalibration_h
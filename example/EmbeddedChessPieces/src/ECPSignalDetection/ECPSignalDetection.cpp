@@ -4,6 +4,15 @@ ECPSignalDetection::ECPSignalDetection(Dezibot &dezibot)
     : dezibot(dezibot) {};
 
 int ECPSignalDetection::measureSignalAngle() {
+    int roundedAngle = std::round(measureSignalBearing());
+
+    // normalize angle to [0, 360]
+    roundedAngle = roundedAngle % 360;
+
+    return roundedAngle;
+};
+
+float ECPSignalDetection::measureSignalBearing() {
     IRMeasurements measurements = measureIR();
 
     // repeat if no sufficient signal could be measured
@@ -13,22 +22,13 @@ int ECPSignalDetection::measureSignalAngle() {
         dezibot.display.println("Trying again...");
         delay(500);
         dezibot.display.clear();
-        return measureSignalAngle();
+        return measureSignalBearing();
     }
 
-    // calculate angle
-    const float resultantX = measurements.east - measurements.west;
-    const float resultantY = measurements.north - measurements.south;
-    float angle = std::atan2(resultantX, resultantY);
-    angle *= (180.0f / M_PI);   // convert from radian to degrees
-
-    int roundedAngle = std::round(angle);
-
-    // normalize angle to [0, 360]
-    // add 360° before applying modulo to prevent negative values
-    roundedAngle = (roundedAngle + 360) % 360;
+    const float angle = bearingCalibration.getBearing(measurements);
 
-    return roundedAngle;
+    // normalize angle to [0, 360)
+    return angle < 0 ? angle + 360.0f : angle;
 };
 
 int ECPSignalDetection::measureDezibotAngle() {
@@ -36,9 +36,22 @@ int ECPSignalDetection::measureDezibotAngle() {
     return (360 - signalAngle) % 360;
 };
 
+float ECPSignalDetection::measureDezibotBearing() {
+    const float signalAngle = measureSignalBearing();
+    return signalAngle == 0.0f ? 0.0f : 360.0f - signalAngle;
+};
+
+ECPBearingCalibration &ECPSignalDetection::getBearingCalibration() {
+    return bearingCalibration;
+};
+
 float ECPSignalDetection::cumulateInfraredValues(bool turnOnIRLight) {
+    if (turnOnIRLight) {
+        return measureIRLockIn().getSum();
+    }
+
     // check for interfering infrared signal
-    IRMeasurements measurements = measureIR();
+    IRMeasurements measurements = measureIRLevel();
 
     // repeat if interfering signal was measured
     if (measurements.hasSignal()) {
@@ -50,36 +63,177 @@ float ECPSignalDetection::cumulateInfraredValues(bool turnOnIRLight) {
         return cumulateInfraredValues(turnOnIRLight);
     }
 
-    if (turnOnIRLight) {
-        dezibot.infraredLight.bottom.turnOn();
-        delay(DELAY_IR_INTERACTION);
+    return measurements.getSum();
+};
 
-        IRMeasurements measurements = measureIR();
+IRMeasurements ECPSignalDetection::measureIR() {
+    const photoTransistors sensors[] = { IR_FRONT, IR_RIGHT, IR_BACK, IR_LEFT };
+    float values[4] = {};
 
-        dezibot.infraredLight.bottom.turnOff();
-        delay(DELAY_IR_INTERACTION);
+    // samples before the call may stem from a previous position, so wait for
+    // a fresh window shared by all four sensors
+    if (!dezibot.lightDetection.isContinuous()) {
+        dezibot.lightDetection.beginContinuous();
+    }
+    delay(MEASUREMENT_WINDOW);
 
-        return measurements.getSum();
+    for (size_t i = 0; i < 4; i++) {
+        const float amplitude = dezibot.lightDetection.getFrequencyAmplitude(
+            sensors[i],
+            BEACON_FREQUENCY,
+            MEASUREMENT_WINDOW
+        );
+        // the fundamental of a square wave is 4 / PI times its mean level
+        values[i] = dezibot.lightDetection.normalizeValue(amplitude) * M_PI / 4;
     }
+    
+    IRMeasurements measurements = { values[0], values[1], values[2], values[3] };
+    return measurements;
+};
 
-    return measurements.getSum();
+void ECPSignalDetection::measureBeacons(
+    const uint16_t *frequencies,
+    size_t count,
+    BeaconBearing *bearings
+) {
+    const photoTransistors sensors[] = { IR_FRONT, IR_RIGHT, IR_BACK, IR_LEFT };
+    float values[MAX_BEACONS][4] = {};
+    count = std::min(count, MAX_BEACONS);
+
+    if (!dezibot.lightDetection.isContinuous()) {
+        dezibot.lightDetection.beginContinuous();
+    }
+    delay(MEASUREMENT_WINDOW);
+
+    // copy every sensor's window once and run all filters on it
+    uint16_t *samples = dezibot.lightDetection.lockScratchBuffer();
+    for (size_t i = 0; i < 4; i++) {
+        const uint32_t sampleCount = dezibot.lightDetection.getWindow(
+            sensors[i],
+            MEASUREMENT_WINDOW,
+            samples,
+            ADC_RING_SIZE
+        );
+        for (size_t beacon = 0; beacon < count; beacon++) {
+            const float amplitude = dezibot.lightDetection.getAmplitude(
+                samples,
+                sampleCount,
+                frequencies[beacon]
+            );
+            // the fundamental of a square wave is 4 / PI times its mean level
+            values[beacon][i] =
+                dezibot.lightDetection.normalizeValue(amplitude) * M_PI / 4;
+        }
+    }
+    dezibot.lightDetection.unlockScratchBuffer();
+
+    for (size_t beacon = 0; beacon < count; beacon++) {
+        IRMeasurements measurements = {
+            values[beacon][0],
+            values[beacon][1],
+            values[beacon][2],
+            values[beacon][3]
+        };
+        bearings[beacon].frequency = frequencies[beacon];
+        bearings[beacon].bearing = bearingCalibration.getBearing(measurements);
+        bearings[beacon].intensity = measurements.getSum();
+        bearings[beacon].hasSignal = measurements.hasSignal();
+    }
 };
 
-IRMeasurements ECPSignalDetection::measureIR() {
+// -----------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// -----------------------------------------------------------------------------
+
+IRMeasurements ECPSignalDetection::measureIRLevel() {
     const photoTransistors sensors[] = { IR_FRONT, IR_RIGHT, IR_BACK, IR_LEFT };
     float values[4] = {};
 
-    // measure all four IR signal values
+    if (!dezibot.lightDetection.isContinuous()) {
+        dezibot.lightDetection.beginContinuous();
+    }
+    delay(MEASUREMENT_WINDOW);
+
     for (size_t i = 0; i < 4; i++) {
-        const int irValue = dezibot.lightDetection.getAverageValue(
+        const windowStatistics statistics = 
+            dezibot.lightDetection.getWindowStatistics(
+                sensors[i],
+                MEASUREMENT_WINDOW
+            );
+        values[i] = dezibot.lightDetection.normalizeValue(statistics.mean);
+    }
+    
+    IRMeasurements measurements = { values[0], values[1], values[2], values[3] };
+    return measurements;
+};
+
+IRMeasurements ECPSignalDetection::measureIRLockIn() {
+    const photoTransistors sensors[] = { IR_FRONT, IR_RIGHT, IR_BACK, IR_LEFT };
+    const size_t phases = 2 * LOCK_IN_PERIODS;
+    uint32_t phaseStarts[phases + 1][4];
+
+    if (!dezibot.lightDetection.isContinuous()) {
+        dezibot.lightDetection.beginContinuous();
+    }
+
+    for (size_t phase = 0; phase < phases; phase++) {
+        if (phase % 2 == 0) {
+            dezibot.infraredLight.bottom.turnOn();
+        } else {
+            dezibot.infraredLight.bottom.turnOff();
+        }
+        for (size_t i = 0; i < 4; i++) {
+            phaseStarts[phase][i] = dezibot.lightDetection.getSampleIndex(sensors[i]);
+        }
+        delay(LOCK_IN_HALF_PERIOD);
+    }
+    dezibot.infraredLight.bottom.turnOff();
+    for (size_t i = 0; i < 4; i++) {
+        phaseStarts[phases][i] = dezibot.lightDetection.getSampleIndex(sensors[i]);
+    }
+
+    // a frame holds 4 bytes per conversion of all sensors round-robin, so
+    // round up the samples of one sensor in it
+    const uint32_t sampleRate = dezibot.lightDetection.getSampleRate();
+    const uint32_t frameSamples =
+        (ADC_FRAME_SIZE / 4 * sampleRate + ADC_SAMPLE_RATE - 1)
+        / ADC_SAMPLE_RATE;
+    const uint32_t settleSamples = frameSamples
+        + (LOCK_IN_LATENCY_MARGIN + LOCK_IN_SETTLE_TIME) * sampleRate / 1000;
+    uint16_t *samples = dezibot.lightDetection.lockScratchBuffer();
+    float values[4] = {};
+
+    for (size_t i = 0; i < 4; i++) {
+        const uint32_t count = dezibot.lightDetection.getSamples(
             sensors[i],
-            MEASUREMENT_COUNT,
-            TIME_BETWEEN_MEASUREMENTS
+            phaseStarts[0][i],
+            samples,
+            ADC_RING_SIZE
         );
-        const float normalizedValue = dezibot.lightDetection.normalizeValue(irValue);
-        values[i] = normalizedValue;
+
+        uint32_t sums[2] = {};
+        uint32_t counts[2] = {};
+        for (size_t phase = 0; phase < phases; phase++) {
+            const uint32_t start = phaseStarts[phase][i] - phaseStarts[0][i];
+            const uint32_t end = std::min(
+                phaseStarts[phase + 1][i] - phaseStarts[0][i],
+                count
+            );
+            for (uint32_t j = start + settleSamples; j < end; j++) {
+                sums[phase % 2] += samples[j];
+                counts[phase % 2]++;
+            }
+        }
+        if (counts[0] == 0 || counts[1] == 0) {
+            continue;
+        }
+
+        const float on = sums[0] / (float) counts[0];
+        const float off = sums[1] / (float) counts[1];
+        values[i] = dezibot.lightDetection.normalizeValue(std::max(on - off, 0.0f));
     }
-    
+    dezibot.lightDetection.unlockScratchBuffer();
+
     IRMeasurements measurements = { values[0], values[1], values[2], values[3] };
     return measurements;
 };
@@ -16,6 +16,8 @@
 
 #include <Dezibot.h>
 
+#include "ECPBearingCalibration.h"
+
 /**
  * @brief Convenience struct for infrared measurements.
  * 
@@ -32,14 +34,14 @@ struct IRMeasurements {
      * @return true if at least one measurement is above threshold.
      * @return false otherwise.
      */
-    bool hasSignal();
+    bool hasSignal() const;
 
     /**
      * @brief Get sum of IR measurements.
      * 
      * @return cumulated infrared values as float.
      */
-    float getSum();
+    float getSum() const;
 
     /**
      * @brief Minimal threshold necessary to be measured before being discarded
@@ -52,6 +54,40 @@ struct IRMeasurements {
     static constexpr float MIN_THRESHOLD_MEASUREMENTS = 0.10f;
 };
 
+/**
+ * @brief Bearing of one beacon measured by
+ *        \p ECPSignalDetection::measureBeacons.
+ * 
+ */
+struct BeaconBearing {
+    /**
+     * @brief Carrier frequency of the beacon in Hz.
+     * 
+     */
+    uint16_t frequency;
+
+    /**
+     * @brief Angle of the beacon clockwise from the dezibot's front in
+     *        degrees, i.e. (-180, 180].
+     * 
+     */
+    float bearing;
+
+    /**
+     * @brief Sum of the beacon's measurements of all sensors, cf.
+     *        \p IRMeasurements::getSum.
+     * 
+     */
+    float intensity;
+
+    /**
+     * @brief True if the beacon was measured above
+     *        \p IRMeasurements::MIN_THRESHOLD_MEASUREMENTS by any sensor.
+     * 
+     */
+    bool hasSignal;
+};
+
 class ECPSignalDetection{
 public:
     ECPSignalDetection(Dezibot &dezibot);
@@ -71,9 +107,44 @@ public:
      *            that, refer to \p measureDezibotAngle.
      * 
      * @return int Angle in degrees, i.e. [0, 360], if signal was detected.
+     * 
+     * @see measureSignalBearing for the unrounded angle
      */
     int measureSignalAngle();
 
+    /**
+     * @brief Measure infrared signal angle like \p measureSignalAngle, but
+     *        without rounding to whole degrees.
+     * 
+     * The angle is corrected by \p bearingCalibration, if the dezibot was
+     * calibrated (cf. \p ECPMovement::calibrateBearing).
+     * 
+     * @warning This function may <b>loop and never return</b> if no infrared
+     *          signal could be detected!
+     * 
+     * @return float Angle in degrees, i.e. [0, 360), if signal was detected.
+     */
+    float measureSignalBearing();
+
+    /**
+     * @brief Measure angle the dezibot is facing like
+     *        \p measureDezibotAngle, but without rounding to whole degrees.
+     * 
+     * @warning This function may <b>loop and never return</b> if no infrared
+     *          signal could be detected!
+     * 
+     * @return float angle in which dezibot is facing, i.e. [0, 360).
+     */
+    float measureDezibotBearing();
+
+    /**
+     * @brief Get calibration of the beacon bearing, e.g. to fit it.
+     * 
+     * @return ECPBearingCalibration& calibration used by
+     *         \p measureSignalBearing and \p measureBeacons
+     */
+    ECPBearingCalibration &getBearingCalibration();
+
     /**
      * @brief Measure angle the dezibot is facing based on infrared signal.
      * 
@@ -92,8 +163,13 @@ public:
     /**
      * @brief Measure infrared values and cumulate them.
      * 
-     * @warning This function may <b>loop and never return</b> if an infrared 
-     *          signal is detected and not removed!
+     * With \p turnOnIRLight, only the reflection of the bottom infrared LED
+     * is measured by lock-in demodulation, see \p measureIRLockIn. Ambient
+     * light and beacons cancel out, so no interfering signal has to be
+     * waited for and a measurement takes about 80 ms.
+     * 
+     * @warning Without \p turnOnIRLight, this function may <b>loop and never
+     *          return</b> if an infrared signal is detected and not removed!
      * 
      * @param turnOnIRLight, true if bottom IR LED should be turned on 
      *        while measuring, default is true
@@ -101,16 +177,103 @@ public:
      */
     float cumulateInfraredValues(bool turnOnIRLight = true);
 
+    /**
+     * @brief Measure infrared signals of the beacon from lateral sensors.
+     * 
+     * Unlike \p measureSignalAngle, return immediately if no signal could be
+     * measured.
+     * 
+     * Only infrared light flashing with \p BEACON_FREQUENCY is measured,
+     * using a Goertzel filter per sensor (cf.
+     * \p LightDetection::getFrequencyAmplitude). Ambient light, other
+     * dezibots' constant infrared LEDs and the bottom infrared LED are
+     * ignored. The amplitude is scaled to the mean level the same square
+     * wave adds to a constant measurement, so thresholds stay comparable.
+     * 
+     * All four sensors are sampled in the background (cf.
+     * \p LightDetection::beginContinuous, started on first usage), so one
+     * measurement waits for a single window of \p MEASUREMENT_WINDOW ms.
+     * 
+     * @return IRMeasurements measurements.
+     */
+    IRMeasurements measureIR();
+
+    /**
+     * @brief Measure bearings of several beacons in one window, each
+     *        flashing with its own frequency.
+     * 
+     * Like \p measureIR, but with a filter bank of one Goertzel filter per
+     * frequency and sensor on the same samples. Frequencies should be at
+     * least 50 Hz apart and no multiples of each other.
+     * 
+     * @param frequencies Carrier frequencies of the beacons in Hz
+     * @param count Number of beacons, at most \p MAX_BEACONS are measured
+     * @param bearings Set to the bearing of each beacon, in the order of
+     *        \p frequencies
+     */
+    void measureBeacons(
+        const uint16_t *frequencies,
+        size_t count,
+        BeaconBearing *bearings
+    );
+
+    /**
+     * @brief Maximum number of beacons measured by \p measureBeacons.
+     * 
+     */
+    static const size_t MAX_BEACONS = 4;
+
+    /**
+     * @brief Frequency in Hz of the beacon, i.e. the dezibot running
+     *        <tt>examples/beacon/beacon.ino</tt>.
+     * 
+     * Below half of the sample rate of \p LightDetection and no multiple of
+     * the mains frequencies.
+     * 
+     */
+    static const uint16_t BEACON_FREQUENCY = 1130;
+
 protected:
     Dezibot &dezibot;
+    ECPBearingCalibration bearingCalibration;
 
 private:
     /**
-     * @brief Measure infrared signals from lateral sensors.
+     * @brief Measure constant infrared level from lateral sensors, e.g. the
+     *        reflection of the bottom infrared LED.
      * 
-     * @return IRMeasurements measurements.
+     * @return IRMeasurements mean of the samples within one window.
      */
-    IRMeasurements measureIR();
+    IRMeasurements measureIRLevel();
+
+    /**
+     * @brief Measure reflection of the bottom infrared LED from lateral
+     *        sensors by lock-in demodulation.
+     * 
+     * The LED is toggled every \p LOCK_IN_HALF_PERIOD ms and the sample
+     * index of every sensor is recorded at each toggle, so the samples are
+     * assigned to the on and off phases synchronously. The ADC stores its
+     * samples one DMA frame of \p ADC_FRAME_SIZE bytes at a time, so up to
+     * one frame converted before a toggle is stored after it. Hence the
+     * first frame of each phase, \p LOCK_IN_LATENCY_MARGIN ms for the
+     * ADC task and \p LOCK_IN_SETTLE_TIME ms while the phototransistors
+     * settle are skipped. The mean of the off phases is subtracted
+     * from the mean of the on phases, cancelling all light that does not
+     * follow the LED.
+     * 
+     * @return IRMeasurements reflected LED light per sensor (normalized).
+     */
+    IRMeasurements measureIRLockIn();
+
+    /**
+     * @brief Timing of \p measureIRLockIn in ms and number of on-off
+     *        periods.
+     * 
+     */
+    static const uint32_t LOCK_IN_HALF_PERIOD = 10;
+    static const uint32_t LOCK_IN_SETTLE_TIME = 2;
+    static const uint32_t LOCK_IN_LATENCY_MARGIN = 1;
+    static const size_t LOCK_IN_PERIODS = 4;
 
     /**
      * @brief How many infrared signals are averaged in \p measureSignalAngle.
@@ -126,12 +289,12 @@ private:
     static const int TIME_BETWEEN_MEASUREMENTS = 30;
 
     /**
-     * @brief Delay after turning infrared LED in \p cumulateInfraredValues 
-     *        on or off.
+     * @brief Window in ms averaged per sensor in \p measureIR, as long as
+     *        the former \p MEASUREMENT_COUNT measurements of one sensor.
      * 
-     * Needed for reliable infrared light.
      */
-    static const int DELAY_IR_INTERACTION = 1000;
+    static const uint32_t MEASUREMENT_WINDOW =
+        MEASUREMENT_COUNT * TIME_BETWEEN_MEASUREMENTS;
 };
 
 #endif // ECPSignalDetection_H
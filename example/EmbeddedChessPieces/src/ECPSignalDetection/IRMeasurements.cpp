@@ -3,7 +3,7 @@
 IRMeasurements::IRMeasurements(float north, float east, float south, float west) 
     : north(north), east(east), south(south), west(west) {};
 
-bool IRMeasurements::hasSignal() {
+bool IRMeasurements::hasSignal() const {
     bool hasSignal = north > MIN_THRESHOLD_MEASUREMENTS 
         || east > MIN_THRESHOLD_MEASUREMENTS 
         || south > MIN_THRESHOLD_MEASUREMENTS 
@@ -12,6 +12,6 @@ bool IRMeasurements::hasSignal() {
     return hasSignal;
 };
 
-float IRMeasurements::getSum() {
+float IRMeasurements::getSum() const {
     return north + east + south + west;
 };
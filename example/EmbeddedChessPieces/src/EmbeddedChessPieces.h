@@ -14,7 +14,9 @@
 
 #include "ECPColorDetection/ECPColorDetection.h"
 #include "ECPChessLogic/ECPChessLogic.h"
+#include "ECPLocalization/ECPLocalizer.h"
 #include "ECPMovement/ECPMovement.h"
+#include "ECPPlanning/ECPPathPlanner.h"
 #include "ECPSignalDetection/ECPSignalDetection.h"
 
 #endif // EmbeddedChessPieces_h
@@ -1,54 +1,34 @@
 #include <Dezibot.h>
-#include <arduinoFFT.h>
-#include <rom/ets_sys.h>
-const uint16_t samples = 256; //This value MUST ALWAYS be a power of 2
-const int centeredThreshold = 50 ;
-//const float signalFrequency = 1000;
-const float samplingFrequency = 4000;
-float vReal[4][samples];
-float vImag[4][samples];
-#define SCL_INDEX 0x00
-#define SCL_TIME 0x01
-#define SCL_FREQUENCY 0x02
-#define SCL_PLOT 0x03
-
-ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal[0], vImag[0], samples, samplingFrequency); /* Create FFT object */
+const int centeredThreshold = 1; //in ADC units
+const float signalFrequency = 1147;
+uint16_t amplitudes[4][SPECTRUM_SIZE/2];
 
 Dezibot dezibot = Dezibot();
 void setup() {
   dezibot.begin();
   Serial.begin(115200);
+  //samples all phototransistors in the background, interrupts stay enabled
+  dezibot.lightDetection.beginContinuous();
   //dezibot.infraredLight.front.turnOn();
   //dezibot.infraredLight.bottom.turnOn();
 }
 
 void loop() {
-  portDISABLE_INTERRUPTS();
-  for(int i = 0; i < samples; i++){
-    vReal[0][i] = dezibot.lightDetection.getValue(IR_FRONT);
-    vImag[0][i] = 0.0;
-    vReal[1][i] = dezibot.lightDetection.getValue(IR_LEFT);
-    vImag[1][i] = 0.0;
-    vReal[2][i] = dezibot.lightDetection.getValue(IR_RIGHT);
-    vImag[2][i] = 0.0;
-    vReal[3][i] = dezibot.lightDetection.getValue(IR_BACK);
-    vImag[3][i] = 0.0;
-    ets_delay_us(125);
-  }
-  
-  portENABLE_INTERRUPTS();
-  //PrintVector(vReal, (samples>>1), 0);
-  
-  //PrintVector(vReal, (samples>>1), 0);
+  const photoTransistors sensors[4] = {IR_FRONT, IR_LEFT, IR_RIGHT, IR_BACK};
   float frequency[4];
   float magnitude[4];
   for(int index = 0; index <4; index++){
-    FFT.setArrays(vReal[index], vImag[index]);
-    FFT.windowing(FFTWindow::Rectangle, FFTDirection::Forward);	/* Weigh data */
-    FFT.compute(FFTDirection::Forward); /* Compute FFT */
-    FFT.complexToMagnitude(); /* Compute magnitudes */
-    FFT.majorPeak(&frequency[index],&magnitude[index]);
-    if(abs(frequency[index]-1147)>10){
+    magnitude[index] = 0;
+    frequency[index] = 0;
+    const uint32_t bins = dezibot.lightDetection.getSpectrum(sensors[index], amplitudes[index]);
+    //bin 0 is the mean, so the peak is searched from bin 1
+    for(uint32_t bin = 1; bin < bins; bin++){
+      if(amplitudes[index][bin] > magnitude[index]){
+        magnitude[index] = amplitudes[index][bin];
+        frequency[index] = dezibot.lightDetection.getBinFrequency(bin);
+      }
+    }
+    if(abs(frequency[index]-signalFrequency) > dezibot.lightDetection.getBinFrequency(1)){
       magnitude[index] = 0;
     }
     Serial.print(index);
@@ -127,30 +107,3 @@ photoTransistors brightest(float *magnitudes){
       return IR_BACK;
   }
 }
-
-void PrintVector(float *vData, uint16_t bufferSize, uint8_t scaleType)
-{
-  for (uint16_t i = 0; i < bufferSize; i++)
-  {
-    float abscissa;
-    /* Print abscissa value */
-    switch (scaleType)
-    {
-      case SCL_INDEX:
-        abscissa = (i * 1.0);
-	break;
-      case SCL_TIME:
-        abscissa = ((i * 1.0) / samplingFrequency);
-	break;
-      case SCL_FREQUENCY:
-        abscissa = ((i * 1.0 * samplingFrequency) / samples);
-	break;
-    }
-    Serial.print(abscissa, 6);
-    if(scaleType==SCL_FREQUENCY)
-      Serial.print("Hz");
-    Serial.print(" ");
-    Serial.println(vData[i], 4);
-  }
-  Serial.println();
-}
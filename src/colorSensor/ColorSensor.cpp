@@ -6,17 +6,55 @@ bool ColorSensor::begin() {
         return false;
     }
 
-    uint8_t configuration = VEML6040_IT_320MS;  // 320 ms integration time
-    configuration += VEML6040_AF_AUTO;          // auto mode
-    configuration += VEML6040_SD_ENABLE;        // enable color sensor
-    rgbwSensor.setConfiguration(configuration);
+    setIntegrationTime(MAX_INTEGRATION_TIME);
     return true;
 };
 
+ColorSensorValues ColorSensor::readAll() {
+    const long remaining = (long) (valuesValidAt - millis());
+    if (remaining > 0) {
+        delay(remaining);
+    }
+
+    // counts are proportional to the integration time
+    const double scale = (double) MAX_INTEGRATION_TIME / integrationTime;
+    ColorSensorValues values;
+    values.red = readRegister(VEML6040_REGISTER_RED) * scale;
+    values.green = readRegister(VEML6040_REGISTER_GREEN) * scale;
+    values.blue = readRegister(VEML6040_REGISTER_BLUE) * scale;
+    values.white = readRegister(VEML6040_REGISTER_WHITE) * scale;
+    values.ambient = values.green * AMBIENT_SENSITIVITY_320MS;
+
+    if (isAdaptiveIntegrationTime) {
+        adaptIntegrationTime(values);
+    }
+    return values;
+};
+
+ColorSensorValues ColorSensor::readAllNormalized() {
+    ColorSensorValues values = readAll();
+    values.ambient = normalizeAmbientValue(values.ambient);
+    values.red = normalizeColorValue(values.red, values.ambient);
+    values.green = normalizeColorValue(values.green, values.ambient);
+    values.blue = normalizeColorValue(values.blue, values.ambient);
+    values.white = normalizeColorValue(values.white, values.ambient);
+    return values;
+};
+
+void ColorSensor::setAdaptiveIntegrationTime(bool isAdaptive) {
+    isAdaptiveIntegrationTime = isAdaptive;
+    if (!isAdaptive && integrationTime != MAX_INTEGRATION_TIME) {
+        setIntegrationTime(MAX_INTEGRATION_TIME);
+    }
+};
+
+uint16_t ColorSensor::getIntegrationTime() {
+    return integrationTime;
+};
+
 double ColorSensor::getNormalizedAmbientValue() {
     double ambient = rgbwSensor.getAmbientLight();  // ambient light in lux
-    double normalizedValue = ambient / MAX_RAW_AMBIENT_VALUE * MAX_NORMALIZED_COLOR_VALUE;
-    return normalizedValue;
+    return normalizeAmbientValue(ambient);
 };
 
 double ColorSensor::getRawColorValue(Color color) {
@@ -33,10 +71,8 @@ double ColorSensor::getRawColorValue(Color color) {
 };
 
 double ColorSensor::getNormalizedColorValue(Color color, double normalizedAmbientLight) {
-    double colorValue = getRawColorValue(color);
-    double normalizedValue = colorValue * normalizedAmbientLight / MAX_RGBW_SENSOR_VALUE * MAX_NORMALIZED_COLOR_VALUE;
-    normalizedValue = std::min(MAX_NORMALIZED_COLOR_VALUE, normalizedValue);
-    return normalizedValue;
+    double colorValue = getRawColorValue(color) * MAX_INTEGRATION_TIME / integrationTime;
+    return normalizeColorValue(colorValue, normalizedAmbientLight);
 };
 
 double ColorSensor::getCCT() {
@@ -52,3 +88,73 @@ double ColorSensor::calculateBrightness(double red, double green, double blue) {
     double normalizedBrightness = std::min(MAX_NORMALIZED_COLOR_VALUE, brightness);
     return normalizedBrightness;
 };
+
+// -----------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// -----------------------------------------------------------------------------
+
+void ColorSensor::setIntegrationTime(uint16_t time) {
+    // the running cycle may still use the previous integration time
+    valuesValidAt = millis() + integrationTime + time;
+    integrationTime = time;
+
+    uint8_t configuration;
+    switch (integrationTime) {
+        case 40:
+            configuration = VEML6040_IT_40MS;
+            break;
+        case 80:
+            configuration = VEML6040_IT_80MS;
+            break;
+        case 160:
+            configuration = VEML6040_IT_160MS;
+            break;
+        default:
+            configuration = VEML6040_IT_320MS;
+            break;
+    }
+    configuration += VEML6040_AF_AUTO;          // auto mode
+    configuration += VEML6040_SD_ENABLE;        // enable color sensor
+    rgbwSensor.setConfiguration(configuration);
+};
+
+uint16_t ColorSensor::readRegister(uint8_t commandCode) {
+    Wire.beginTransmission(VEML6040_I2C_ADDRESS);
+    Wire.write(commandCode);
+    Wire.endTransmission(false);    // repeated start
+    Wire.requestFrom((uint8_t) VEML6040_I2C_ADDRESS, (uint8_t) 2);
+    const uint8_t lsb = Wire.read();
+    const uint8_t msb = Wire.read();
+    return (msb << 8) | lsb;
+};
+
+void ColorSensor::adaptIntegrationTime(const ColorSensorValues &values) {
+    const double maxValue = std::max({values.red, values.green, values.blue, values.white});
+    const double highCount = ADAPTIVE_HIGH_SHARE * MAX_RGBW_SENSOR_VALUE;
+    const double lowCount = ADAPTIVE_LOW_SHARE * MAX_RGBW_SENSOR_VALUE;
+
+    // expected count at integration time t is maxValue * t / MAX_INTEGRATION_TIME
+    uint16_t nextTime = integrationTime;
+    while (nextTime > MIN_INTEGRATION_TIME
+            && maxValue * nextTime / MAX_INTEGRATION_TIME > highCount) {
+        nextTime /= 2;
+    }
+    while (nextTime < MAX_INTEGRATION_TIME
+            && maxValue * nextTime * 2 / MAX_INTEGRATION_TIME < lowCount) {
+        nextTime *= 2;
+    }
+
+    if (nextTime != integrationTime) {
+        setIntegrationTime(nextTime);
+    }
+};
+
+double ColorSensor::normalizeAmbientValue(double ambient) {
+    return ambient / MAX_RAW_AMBIENT_VALUE * MAX_NORMALIZED_COLOR_VALUE;
+};
+
+double ColorSensor::normalizeColorValue(double colorValue, double normalizedAmbientLight) {
+    double normalizedValue = colorValue * normalizedAmbientLight / MAX_RGBW_SENSOR_VALUE * MAX_NORMALIZED_COLOR_VALUE;
+    normalizedValue = std::min(MAX_NORMALIZED_COLOR_VALUE, normalizedValue);
+    return normalizedValue;
+};
@@ -12,12 +12,39 @@
 #define ChessColorDetection_h
 
 #include <algorithm>
+#include <Arduino.h>
+#include <Wire.h>
 #include <veml6040.h>
 
 #define MAX_NORMALIZED_COLOR_VALUE 255.0
 #define MAX_RAW_AMBIENT_VALUE 2061.0
 #define MAX_RGBW_SENSOR_VALUE 65535.0
 
+#define VEML6040_REGISTER_RED 0x08
+#define VEML6040_REGISTER_GREEN 0x09
+#define VEML6040_REGISTER_BLUE 0x0A
+#define VEML6040_REGISTER_WHITE 0x0B
+
+// lux per count of the green channel at 320 ms integration time
+#define AMBIENT_SENSITIVITY_320MS 0.03146
+
+/**
+ * @brief Values of all channels of the color sensor, taken from the same
+ *        integration cycle.
+ * 
+ * Color values are raw counts scaled to an integration time of
+ * \p ColorSensor::MAX_INTEGRATION_TIME, so they do not depend on the current
+ * integration time. Ambient light is in lux.
+ * 
+ */
+struct ColorSensorValues {
+    double red;
+    double green;
+    double blue;
+    double white;
+    double ambient;
+};
+
 /**
  * @brief Controller for VEML6040 color sensor of the Dezibot.
  * 
@@ -34,6 +61,13 @@ public:
         WHITE
     };
 
+    static constexpr uint16_t MIN_INTEGRATION_TIME = 40;
+    static constexpr uint16_t MAX_INTEGRATION_TIME = 320;
+
+    //adaptive integration time shortens above and lengthens below these shares of the 16 bit range
+    static constexpr double ADAPTIVE_HIGH_SHARE = 0.5;
+    static constexpr double ADAPTIVE_LOW_SHARE = 0.4;
+
     /**
      * @brief Initialize VEML6040 color sensor and begin transmission
      * 
@@ -42,6 +76,49 @@ public:
      */
     bool begin();
 
+    /**
+     * @brief Read red, green, blue and white channel in one burst, i.e. four
+     *        register reads with repeated starts.
+     * 
+     * Unlike separate calls of \p getRawColorValue, all values stem from the
+     * same integration cycle. Ambient light is derived from the green channel,
+     * like \p VEML6040::getAmbientLight does. If the integration time changed
+     * recently, waits until the sensor measured with the new one.
+     * 
+     * In adaptive mode, the integration time for the next call is chosen
+     * based on the values read.
+     * 
+     * @return ColorSensorValues values scaled to \p MAX_INTEGRATION_TIME
+     */
+    ColorSensorValues readAll();
+
+    /**
+     * @brief Read all channels like \p readAll and normalize them like
+     *        \p getNormalizedAmbientValue and \p getNormalizedColorValue.
+     * 
+     * @return ColorSensorValues normalized values on a scale of 0 to 255
+     */
+    ColorSensorValues readAllNormalized();
+
+    /**
+     * @brief Enable or disable adaptive integration time.
+     * 
+     * When enabled, \p readAll shortens the integration time down to
+     * \p MIN_INTEGRATION_TIME if the signal is strong, so new values are
+     * available sooner. When disabled, \p MAX_INTEGRATION_TIME is used.
+     * 
+     * @param isAdaptive true to enable adaptive integration time
+     */
+    void setAdaptiveIntegrationTime(bool isAdaptive);
+
+    /**
+     * @brief Get current integration time, i.e. the time until the sensor
+     *        provides new values.
+     * 
+     * @return uint16_t integration time in ms
+     */
+    uint16_t getIntegrationTime();
+
     /**
      * @brief Get normalized value of ambient light sensor on a scale from 0 to 255.
      * 
@@ -92,6 +169,50 @@ public:
      * @return double approximation for color value
      */
     double calculateBrightness(double red, double green, double blue);
+
+private:
+    /**
+     * @brief Current integration time in ms.
+     * 
+     */
+    uint16_t integrationTime = MAX_INTEGRATION_TIME;
+
+    bool isAdaptiveIntegrationTime = false;
+
+    /**
+     * @brief Time in ms (cf. \p millis) from which the sensor provides values
+     *        measured with the current integration time.
+     * 
+     */
+    unsigned long valuesValidAt = 0;
+
+    /**
+     * @brief Write configuration with the given integration time to the
+     *        sensor.
+     * 
+     * @param time integration time in ms, one of 40, 80, 160 and 320
+     */
+    void setIntegrationTime(uint16_t time);
+
+    /**
+     * @brief Read 16 bit data register without releasing the bus before.
+     * 
+     * @param commandCode register to read
+     * @return uint16_t register value
+     */
+    uint16_t readRegister(uint8_t commandCode);
+
+    /**
+     * @brief Choose integration time for the next measurements, such that the
+     *        highest channel stays within \p ADAPTIVE_LOW_SHARE and
+     *        \p ADAPTIVE_HIGH_SHARE of the 16 bit range.
+     * 
+     * @param values last values, scaled to \p MAX_INTEGRATION_TIME
+     */
+    void adaptIntegrationTime(const ColorSensorValues &values);
+
+    double normalizeAmbientValue(double ambient);
+    double normalizeColorValue(double colorValue, double normalizedAmbientLight);
 };
 
 #endif // ChessColorDetection_h
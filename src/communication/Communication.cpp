@@ -66,6 +66,11 @@ void Communication::onReceive(void (*callbackFunc)(String &msg))
     userCallback = callbackFunc;
 }
 
+uint32_t Communication::getNodeTime(void)
+{
+    return mesh.getNodeTime();
+}
+
 void Communication::begin(void)
 {
     Serial.begin(115200);
@@ -23,6 +23,13 @@ public:
     void sendMessage(String msg);
 
     void onReceive(void (*callbackFunc)(String &msg));
+
+    /**
+     * @brief get the time of the mesh, which is synchronized between all nodes
+     * 
+     * @return the mesh time in microseconds, overflows after about 71 minutes
+     */
+    static uint32_t getNodeTime(void);
 private:
     static void (*userCallback)(String &msg);
     static void receivedCallback(uint32_t from, String &msg);
@@ -1,12 +1,186 @@
 #include "LightDetection.h"
 #include <limits.h>
+#include <algorithm>
 
 void LightDetection::begin(void){
     LightDetection::beginInfrared();
     LightDetection::beginDaylight();
 };
 
+void LightDetection::beginContinuous(void){
+    if(xAdcTaskHandle){
+        return;
+    }
+    digitalWrite(IR_PT_ENABLE,HIGH);
+    digitalWrite(DL_PT_ENABLE,HIGH);
+
+    adc_digi_pattern_config_t pattern[SENSOR_COUNT] = {};
+    uint32_t channelMask = 0;
+    for(uint8_t sensor = 0; sensor < SENSOR_COUNT; sensor++){
+        //on the ESP32-S3, GPIO 1-10 are the channels 0-9 of ADC1
+        const uint8_t channel = getPin((photoTransistors) sensor) - 1;
+        pattern[sensor].atten = ADC_ATTEN_DB_11; //same attenuation as analogRead()
+        pattern[sensor].channel = channel;
+        pattern[sensor].unit = 0;
+        pattern[sensor].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        channelMask |= 1 << channel;
+    }
+
+    adc_digi_init_config_t initConfig = {
+        .max_store_buf_size = 4*ADC_FRAME_SIZE,
+        .conv_num_each_intr = ADC_FRAME_SIZE,
+        .adc1_chan_mask = channelMask,
+        .adc2_chan_mask = 0
+    };
+    adc_digi_initialize(&initConfig);
+
+    adc_digi_configuration_t config = {
+        .conv_limit_en = false,
+        .conv_limit_num = 250,
+        .pattern_num = SENSOR_COUNT,
+        .adc_pattern = pattern,
+        .sample_freq_hz = ADC_SAMPLE_RATE,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2
+    };
+    adc_digi_controller_configure(&config);
+    adc_digi_start();
+
+    xAdcTaskHandle = xTaskCreateStatic(adcTask, "LightDetection", ADC_TASK_STACK_SIZE, NULL, ADC_TASK_PRIORITY, adcTaskStack, &adcTaskBuffer);
+};
+
+bool LightDetection::isContinuous(void){
+    return xAdcTaskHandle != NULL;
+};
+
+uint32_t LightDetection::getSampleRate(void){
+    return ADC_SAMPLE_RATE / SENSOR_COUNT;
+};
+
+uint32_t LightDetection::getWindow(photoTransistors sensor, uint32_t windowMs, uint16_t *samples, uint32_t maxSamples){
+    if(!isContinuous()){
+        return 0;
+    }
+    //keep a frame of distance to the writer, so it cannot overwrite the samples while they are copied
+    uint32_t count = windowMs * getSampleRate() / 1000;
+    count = std::min(count, maxSamples);
+    count = std::min(count, (uint32_t) (ADC_RING_SIZE - ADC_FRAME_SIZE / 4));
+
+    for(;;){
+        const uint32_t end = __atomic_load_n(&writeIndex[sensor], __ATOMIC_ACQUIRE);
+        const uint32_t available = std::min(count, end);
+        for(uint32_t i = 0; i < available; i++){
+            samples[i] = ringBuffer[sensor][(end - available + i) % ADC_RING_SIZE];
+        }
+        //retry if the writer lapped the copied samples in the meantime
+        const uint32_t written = __atomic_load_n(&writeIndex[sensor], __ATOMIC_ACQUIRE) - end;
+        if(written + available <= ADC_RING_SIZE){
+            return available;
+        }
+    }
+};
+
+uint32_t LightDetection::getSampleIndex(photoTransistors sensor){
+    return __atomic_load_n(&writeIndex[sensor], __ATOMIC_ACQUIRE);
+};
+
+uint32_t LightDetection::getSamples(photoTransistors sensor, uint32_t fromIndex, uint16_t *samples, uint32_t maxSamples){
+    const uint32_t end = getSampleIndex(sensor);
+    if(end - fromIndex > ADC_RING_SIZE - ADC_FRAME_SIZE / 4){
+        return 0;
+    }
+    const uint32_t count = std::min(end - fromIndex, maxSamples);
+    for(uint32_t i = 0; i < count; i++){
+        samples[i] = ringBuffer[sensor][(fromIndex + i) % ADC_RING_SIZE];
+    }
+    //the first samples are lost if the writer lapped them in the meantime
+    if(getSampleIndex(sensor) - fromIndex > ADC_RING_SIZE){
+        return 0;
+    }
+    return count;
+};
+
+uint16_t *LightDetection::lockScratchBuffer(void){
+    //created on first use, so it does not depend on the order of begin() and the first measurement
+    portENTER_CRITICAL(&scratchMutexLock);
+    if(scratchMutex == NULL){
+        scratchMutex = xSemaphoreCreateMutexStatic(&scratchMutexBuffer);
+    }
+    portEXIT_CRITICAL(&scratchMutexLock);
+    xSemaphoreTake(scratchMutex, portMAX_DELAY);
+    return scratchBuffer;
+};
+
+void LightDetection::unlockScratchBuffer(void){
+    xSemaphoreGive(scratchMutex);
+};
+
+windowStatistics LightDetection::getWindowStatistics(photoTransistors sensor, uint32_t windowMs){
+    windowStatistics statistics = {0.0f, 0, 0.0f, 0};
+    uint16_t *samples = lockScratchBuffer();
+    const uint32_t count = getWindow(sensor, windowMs, samples, ADC_RING_SIZE);
+    if(count == 0){
+        unlockScratchBuffer();
+        return statistics;
+    }
+
+    uint64_t sum = 0;
+    uint64_t squaredSum = 0;
+    for(uint32_t i = 0; i < count; i++){
+        sum += samples[i];
+        squaredSum += samples[i] * samples[i];
+    }
+    statistics.count = count;
+    statistics.mean = (float) sum / count;
+    statistics.variance = (float) squaredSum / count - statistics.mean * statistics.mean;
+
+    std::nth_element(samples, samples + count / 2, samples + count);
+    statistics.median = samples[count / 2];
+    unlockScratchBuffer();
+    return statistics;
+};
+
+float LightDetection::getFrequencyAmplitude(photoTransistors sensor, uint16_t frequency, uint32_t windowMs){
+    if(!isContinuous()){
+        beginContinuous();
+    }
+    uint16_t *samples = lockScratchBuffer();
+    const uint32_t count = getWindow(sensor, windowMs, samples, ADC_RING_SIZE);
+    const float amplitude = getAmplitude(samples, count, frequency);
+    unlockScratchBuffer();
+    return amplitude;
+};
+
+float LightDetection::getAmplitude(const uint16_t *samples, uint32_t count, uint16_t frequency){
+    if(count == 0){
+        return 0;
+    }
+    //remove the mean, so the state only grows with the wanted frequency
+    uint32_t sum = 0;
+    for(uint32_t i = 0; i < count; i++){
+        sum += samples[i];
+    }
+    const int32_t mean = sum / count;
+
+    const float omega = 2.0f * PI * frequency / getSampleRate();
+    const int32_t coefficient = lroundf(2.0f * cosf(omega) * (1 << GOERTZEL_FRACTION_BITS));
+    int64_t previous = 0;
+    int64_t beforePrevious = 0;
+    for(uint32_t i = 0; i < count; i++){
+        const int64_t current = (samples[i] - mean) + ((coefficient * previous) >> GOERTZEL_FRACTION_BITS) - beforePrevious;
+        beforePrevious = previous;
+        previous = current;
+    }
+
+    const int64_t power = previous * previous + beforePrevious * beforePrevious - ((coefficient * previous) >> GOERTZEL_FRACTION_BITS) * beforePrevious;
+    return 2.0f * sqrtf(std::max((float) power, 0.0f)) / count;
+};
+
 uint16_t LightDetection::getValue(photoTransistors sensor){
+    if(isContinuous()){
+        const uint32_t end = __atomic_load_n(&writeIndex[sensor], __ATOMIC_ACQUIRE);
+        return end == 0 ? 0 : ringBuffer[sensor][(end - 1) % ADC_RING_SIZE];
+    }
     switch(sensor){
         //Fall Through intended
         case IR_FRONT:
@@ -67,6 +241,51 @@ float LightDetection::normalizeValue(uint32_t sensorValue, uint32_t maxValue) {
     return ((float) sensorValue) / ((float) maxValue);
 }
 
+void LightDetection::adcTask(void * args){
+    int8_t channelToSensor[16];
+    memset(channelToSensor, -1, sizeof(channelToSensor));
+    for(uint8_t sensor = 0; sensor < SENSOR_COUNT; sensor++){
+        channelToSensor[getPin((photoTransistors) sensor) - 1] = sensor;
+    }
+
+    uint8_t frame[ADC_FRAME_SIZE];
+    for(;;){
+        uint32_t length = 0;
+        //ESP_ERR_INVALID_STATE reports an overflow of the DMA buffer, but the read bytes are still valid
+        const esp_err_t result = adc_digi_read_bytes(frame, ADC_FRAME_SIZE, &length, ADC_MAX_DELAY);
+        if(result != ESP_OK && result != ESP_ERR_INVALID_STATE){
+            continue;
+        }
+        for(uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= length; i += sizeof(adc_digi_output_data_t)){
+            const adc_digi_output_data_t *sample = (const adc_digi_output_data_t *) &frame[i];
+            const int8_t sensor = channelToSensor[sample->type2.channel];
+            if(sample->type2.unit != 0 || sensor < 0){
+                continue;
+            }
+            const uint32_t index = writeIndex[sensor];
+            ringBuffer[sensor][index % ADC_RING_SIZE] = sample->type2.data;
+            __atomic_store_n(&writeIndex[sensor], index + 1, __ATOMIC_RELEASE);
+        }
+    }
+};
+
+uint8_t LightDetection::getPin(photoTransistors sensor){
+    switch(sensor){
+        case IR_FRONT:
+            return IR_PT_FRONT_ADC;
+        case IR_LEFT:
+            return IR_PT_LEFT_ADC;
+        case IR_RIGHT:
+            return IR_PT_RIGHT_ADC;
+        case IR_BACK:
+            return IR_PT_BACK_ADC;
+        case DL_FRONT:
+            return DL_PT_FRONT_ADC;
+        default:
+            return DL_PT_BOTTOM_ADC;
+    }
+};
+
 void LightDetection::beginInfrared(void){
     digitalWrite(IR_PT_ENABLE,true);
     pinMode(IR_PT_ENABLE, OUTPUT);
@@ -14,6 +14,21 @@
 
 #include <stdint.h>
 #include <Arduino.h>
+#include <driver/adc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define ADC_SAMPLE_RATE      30000 // conversions per second of all phototransistors together
+#define ADC_RING_SIZE        1024 // samples kept per phototransistor, about 200ms
+#define ADC_FRAME_SIZE       256 // bytes read from the DMA buffer at once, 4 bytes per sample
+#define ADC_TASK_STACK_SIZE  2048
+#define ADC_TASK_PRIORITY    5
+#define SPECTRUM_SIZE        256 // samples per FFT, must be a power of 2
+
+//the vector extensions of the ESP32-S3 are used through esp-dsp if it is available
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && __has_include(<esp_dsp.h>)
+#define LIGHT_DETECTION_ESP_DSP
+#endif
 
 enum photoTransistors{
     IR_LEFT,
@@ -32,6 +47,13 @@ struct averageMeasurement {
     bool done;
 };
 
+struct windowStatistics {
+    float mean;
+    uint16_t median;
+    float variance;
+    uint32_t count; // number of samples in the window, 0 if no samples are available
+};
+
 enum ptType{
     IR,
     DAYLIGHT
@@ -49,6 +71,122 @@ public:
      */
     static void begin(void);
 
+    /**
+     * @brief start sampling all phototransistors round-robin in the background using the continuous (DMA) mode of the ADC.
+     * Every sample is stored in a ring buffer per phototransistor, see getWindow() and getWindowStatistics().
+     * Afterwards getValue() returns the latest sample instead of reading the ADC, as analogRead() cannot be used anymore.
+     * Both phototransistor groups stay enabled. Calling it again has no effect.
+     * 
+     */
+    static void beginContinuous(void);
+
+    /**
+     * @return true if beginContinuous() was called
+     */
+    static bool isContinuous(void);
+
+    /**
+     * @return the number of samples per second of each phototransistor in continuous mode
+     */
+    static uint32_t getSampleRate(void);
+
+    /**
+     * @brief copy the samples of the last windowMs milliseconds of a phototransistor, oldest first.
+     * Never blocks, the samples are taken from the ring buffer filled by beginContinuous().
+     * 
+     * @param sensor which sensor to read
+     * @param windowMs length of the window, at most ADC_RING_SIZE samples are available
+     * @param samples buffer for the samples
+     * @param maxSamples size of the buffer
+     * @return the number of copied samples, 0 if continuous sampling was not started
+     */
+    static uint32_t getWindow(photoTransistors sensor, uint32_t windowMs, uint16_t *samples, uint32_t maxSamples);
+
+    /**
+     * @return the number of samples of a phototransistor stored so far, i.e. the index of the next sample, e.g. to mark the start of a phase in getSamples()
+     */
+    static uint32_t getSampleIndex(photoTransistors sensor);
+
+    /**
+     * @brief copy the samples of a phototransistor starting at an index returned by getSampleIndex(), oldest first.
+     * 
+     * @param sensor which sensor to read
+     * @param fromIndex index of the first sample
+     * @param samples buffer for the samples
+     * @param maxSamples size of the buffer
+     * @return the number of copied samples, 0 if the first sample was already overwritten
+     */
+    static uint32_t getSamples(photoTransistors sensor, uint32_t fromIndex, uint16_t *samples, uint32_t maxSamples);
+
+    /**
+     * @brief lock the shared buffer of ADC_RING_SIZE samples, e.g. for getWindow(), so a whole window does not have to live on the stack of the calling task.
+     * Blocks until the buffer is unlocked by unlockScratchBuffer(). Do not call other methods of LightDetection that use it, like getWindowStatistics(), while it is locked.
+     * 
+     * @return the buffer
+     */
+    static uint16_t *lockScratchBuffer(void);
+
+    /**
+     * @brief unlock the buffer returned by lockScratchBuffer()
+     * 
+     */
+    static void unlockScratchBuffer(void);
+
+    /**
+     * @brief calculate mean, median and variance of the samples of the last windowMs milliseconds of a phototransistor.
+     * 
+     * @param sensor which sensor to read
+     * @param windowMs length of the window, at most ADC_RING_SIZE samples are used
+     * @return the statistics of the window, count is 0 if continuous sampling was not started
+     */
+    static windowStatistics getWindowStatistics(photoTransistors sensor, uint32_t windowMs);
+
+    /**
+     * @brief measure the amplitude of light flashing with a specific frequency, e.g. an IR LED using InfraredLED::sendFrequency().
+     * Light of other frequencies, like daylight or constant IR LEDs, is ignored. Starts continuous sampling if necessary.
+     * 
+     * @param sensor which sensor to read
+     * @param frequency frequency of the light in Hz, must be below half of getSampleRate()
+     * @param windowMs length of the measured window, longer windows reject neighbouring frequencies better
+     * @return the amplitude of the frequency in ADC units
+     */
+    static float getFrequencyAmplitude(photoTransistors sensor, uint16_t frequency, uint32_t windowMs);
+
+    /**
+     * @brief calculate the amplitude of one frequency in samples taken with getSampleRate() using a fixed-point Goertzel filter.
+     * Much cheaper than a FFT if only few frequencies are of interest.
+     * 
+     * @param samples samples of one sensor, e.g. from getWindow()
+     * @param count number of samples
+     * @param frequency frequency in Hz, must be below half of getSampleRate()
+     * @return the amplitude of the frequency in ADC units, the mean of the samples is ignored
+     */
+    static float getAmplitude(const uint16_t *samples, uint32_t count, uint16_t frequency);
+
+    /**
+     * @brief calculate the spectrum of the last SPECTRUM_SIZE samples of a phototransistor using a fixed-point FFT.
+     * Starts continuous sampling if necessary. Bin i covers the frequency getBinFrequency(i).
+     * 
+     * @param sensor which sensor to read
+     * @param amplitudes buffer for the amplitudes of the bins 0 to SPECTRUM_SIZE/2-1 in ADC units, bin 0 is the mean
+     * @return the number of bins, 0 if there are not enough samples yet
+     */
+    static uint32_t getSpectrum(photoTransistors sensor, uint16_t *amplitudes);
+
+    /**
+     * @return the center frequency in Hz of a bin of getSpectrum()
+     */
+    static float getBinFrequency(uint32_t bin);
+
+    /**
+     * @brief calculate the FFT of SPECTRUM_SIZE real Q15 samples in place.
+     * The samples are packed into SPECTRUM_SIZE/2 complex values, so no buffer for imaginary parts is needed.
+     * Every stage is scaled by 1/2 to prevent overflows, i.e. a sine of amplitude a results in a bin of magnitude a.
+     * 
+     * @param data SPECTRUM_SIZE samples, afterwards the real parts of bin 0 and SPECTRUM_SIZE/2, followed by real and imaginary part of the bins 1 to SPECTRUM_SIZE/2-1
+     */
+    static void realFFT(int16_t *data);
+
     /**
      * @brief reads the Value of the specified sensor
      * 
@@ -100,6 +238,47 @@ protected:
     static const uint16_t MAX_SENSOR_VALUE = 4095;
 
     
+    static const uint8_t SENSOR_COUNT = 6;
+    static const uint8_t GOERTZEL_FRACTION_BITS = 14; //fixed-point format of the Goertzel coefficient, which is in [-2, 2]
+    static const uint8_t SPECTRUM_INPUT_SHIFT = 2; //12 bit samples without mean to Q15, leaving headroom for the magnitude of the packed complex values
+
+    //cosine and sine of 2*pi*i/SPECTRUM_SIZE in Q15, shared by the FFT and the split into real bins
+    static inline int16_t twiddleCos[SPECTRUM_SIZE / 2];
+    static inline int16_t twiddleSin[SPECTRUM_SIZE / 2];
+    static inline bool isSpectrumInitialized = false;
+
+    //written only by adcTask, the index is published after the sample is stored, so readers never lock
+    static inline uint16_t ringBuffer[SENSOR_COUNT][ADC_RING_SIZE];
+    static inline uint32_t writeIndex[SENSOR_COUNT] = {};
+
+    //shared by getWindowStatistics(), getFrequencyAmplitude() and the users of lockScratchBuffer(), a window of 2KB would overflow small task stacks
+    static inline uint16_t scratchBuffer[ADC_RING_SIZE];
+    static inline StaticSemaphore_t scratchMutexBuffer;
+    static inline SemaphoreHandle_t scratchMutex = NULL;
+    static inline portMUX_TYPE scratchMutexLock = portMUX_INITIALIZER_UNLOCKED;
+
+    static inline StackType_t adcTaskStack[ADC_TASK_STACK_SIZE];
+    static inline StaticTask_t adcTaskBuffer;
+    static inline TaskHandle_t xAdcTaskHandle = NULL;
+
+    /**
+     * @brief moves the samples from the DMA buffer of the ADC into the ring buffers
+     * 
+     */
+    static void adcTask(void * args);
+
+    /**
+     * @return the pin of the ADC the sensor is connected to
+     */
+    static uint8_t getPin(photoTransistors sensor);
+
+    static void beginSpectrum(void);
+
+    /**
+     * @brief complex radix-2 FFT of count values in place, scaled by 1/2 per stage, count must divide SPECTRUM_SIZE
+     */
+    static void complexFFT(int16_t *data, uint32_t count);
+
     static void beginInfrared(void);
     static void beginDaylight(void);
     static uint16_t readIRPT(photoTransistors sensor);
@@ -0,0 +1,132 @@
+#include "LightDetection.h"
+#include <algorithm>
+
+#ifdef LIGHT_DETECTION_ESP_DSP
+#include <esp_dsp.h>
+#endif
+
+uint32_t LightDetection::getSpectrum(photoTransistors sensor, uint16_t *amplitudes){
+    if(!isContinuous()){
+        beginContinuous();
+    }
+    beginSpectrum();
+
+    uint16_t samples[SPECTRUM_SIZE];
+    const uint32_t windowMs = (SPECTRUM_SIZE * 1000 + getSampleRate() - 1) / getSampleRate();
+    if(getWindow(sensor, windowMs, samples, SPECTRUM_SIZE) < SPECTRUM_SIZE){
+        return 0;
+    }
+
+    //remove the mean, so the small signals use the whole range of Q15
+    uint32_t sum = 0;
+    for(uint32_t i = 0; i < SPECTRUM_SIZE; i++){
+        sum += samples[i];
+    }
+    const int32_t mean = sum / SPECTRUM_SIZE;
+    int16_t data[SPECTRUM_SIZE];
+    for(uint32_t i = 0; i < SPECTRUM_SIZE; i++){
+        data[i] = (samples[i] - mean) << SPECTRUM_INPUT_SHIFT;
+    }
+    realFFT(data);
+
+    amplitudes[0] = mean;
+    for(uint32_t bin = 1; bin < SPECTRUM_SIZE / 2; bin++){
+        const int32_t re = data[2*bin];
+        const int32_t im = data[2*bin + 1];
+        amplitudes[bin] = lroundf(sqrtf(re * re + im * im) / (1 << SPECTRUM_INPUT_SHIFT));
+    }
+    return SPECTRUM_SIZE / 2;
+};
+
+float LightDetection::getBinFrequency(uint32_t bin){
+    return (float) bin * getSampleRate() / SPECTRUM_SIZE;
+};
+
+void LightDetection::realFFT(int16_t *data){
+    beginSpectrum();
+    const uint32_t half = SPECTRUM_SIZE / 2;
+    //even samples are the real parts, odd samples the imaginary parts
+    complexFFT(data, half);
+
+    //split the spectrum z of the packed samples into the spectrum x of the real samples:
+    //x[k] = (z[k] + conj(z[half-k]))/2 - i*w^k*(z[k] - conj(z[half-k]))/2, bins k and half-k are calculated together
+    const int32_t re0 = data[0];
+    const int32_t im0 = data[1];
+    data[0] = (re0 + im0) >> 1;
+    data[1] = (re0 - im0) >> 1;
+    for(uint32_t k = 1; k <= half / 2; k++){
+        const int32_t aRe = data[2*k];
+        const int32_t aIm = data[2*k + 1];
+        const int32_t bRe = data[2*(half - k)];
+        const int32_t bIm = data[2*(half - k) + 1];
+
+        const int32_t evenRe = (aRe + bRe) >> 1;
+        const int32_t evenIm = (aIm - bIm) >> 1;
+        const int32_t oddRe = (aRe - bRe) >> 1;
+        const int32_t oddIm = (aIm + bIm) >> 1;
+        const int32_t c = twiddleCos[k];
+        const int32_t s = twiddleSin[k];
+        const int32_t rotatedRe = (c * oddIm - s * oddRe) >> 15;
+        const int32_t rotatedIm = (c * oddRe + s * oddIm) >> 15;
+
+        data[2*k] = std::clamp(evenRe + rotatedRe, (int32_t) INT16_MIN, (int32_t) INT16_MAX);
+        data[2*k + 1] = std::clamp(evenIm - rotatedIm, (int32_t) INT16_MIN, (int32_t) INT16_MAX);
+        data[2*(half - k)] = std::clamp(evenRe - rotatedRe, (int32_t) INT16_MIN, (int32_t) INT16_MAX);
+        data[2*(half - k) + 1] = std::clamp(-evenIm - rotatedIm, (int32_t) INT16_MIN, (int32_t) INT16_MAX);
+    }
+};
+
+void LightDetection::beginSpectrum(void){
+    if(isSpectrumInitialized){
+        return;
+    }
+    for(uint32_t i = 0; i < SPECTRUM_SIZE / 2; i++){
+        const float angle = 2.0f * PI * i / SPECTRUM_SIZE;
+        twiddleCos[i] = std::min(lroundf(cosf(angle) * 32768.0f), (long) INT16_MAX);
+        twiddleSin[i] = std::min(lroundf(sinf(angle) * 32768.0f), (long) INT16_MAX);
+    }
+#ifdef LIGHT_DETECTION_ESP_DSP
+    dsps_fft2r_init_sc16(NULL, SPECTRUM_SIZE / 2);
+#endif
+    isSpectrumInitialized = true;
+};
+
+void LightDetection::complexFFT(int16_t *data, uint32_t count){
+#ifdef LIGHT_DETECTION_ESP_DSP
+    //uses the vector instructions of the ESP32-S3, scaled by 1/2 per stage as well
+    dsps_fft2r_sc16(data, count);
+    dsps_bit_rev_sc16_ansi(data, count);
+#else
+    //bit reversed order first, so the butterflies work in place
+    for(uint32_t i = 1, j = 0; i < count; i++){
+        uint32_t bit = count >> 1;
+        for(; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j){
+            std::swap(data[2*i], data[2*j]);
+            std::swap(data[2*i + 1], data[2*j + 1]);
+        }
+    }
+
+    for(uint32_t length = 2; length <= count; length <<= 1){
+        const uint32_t step = SPECTRUM_SIZE / length;
+        for(uint32_t start = 0; start < count; start += length){
+            for(uint32_t k = 0; k < length / 2; k++){
+                const uint32_t a = start + k;
+                const uint32_t b = a + length / 2;
+                const int32_t c = twiddleCos[k * step];
+                const int32_t s = twiddleSin[k * step];
+                //b * e^(-i*angle)
+                const int32_t re = (data[2*b] * c + data[2*b + 1] * s) >> 15;
+                const int32_t im = (data[2*b + 1] * c - data[2*b] * s) >> 15;
+                data[2*b] = (data[2*a] - re) >> 1;
+                data[2*b + 1] = (data[2*a + 1] - im) >> 1;
+                data[2*a] = (data[2*a] + re) >> 1;
+                data[2*a + 1] = (data[2*a + 1] + im) >> 1;
+            }
+        }
+    }
+#endif
+};
@@ -24,180 +24,289 @@ void Motion::begin(void) {
         .clk_cfg          = LEDC_AUTO_CLK
     }; 
     ledc_timer_config(&motor_timer);
+    //needed by Motor::setSpeed to ramp in hardware, returns an error if already installed
+    ledc_fade_func_install(0);
     Motion::left.begin();
     Motion::right.begin();
     detection.begin();
+    if(!xMotorTaskHandle){
+        commandQueue = xQueueCreateStatic(MOTION_QUEUE_LENGTH, sizeof(MotionCommand), commandQueueStorage, &commandQueueBuffer);
+        xMotorTaskHandle = xTaskCreateStatic(motorTask, "Motion", MOTOR_TASK_STACK_SIZE, NULL, MOTOR_TASK_PRIORITY, motorTaskStack, &motorTaskBuffer);
+    }
 };
-void Motion::moveTask(void * args) {
-    uint32_t runtime = (uint32_t)args;
+void Motion::motorTask(void * args) {
+    MotionCommand command;
+    MotionCommand current;
+    bool isActive = false;
+    TickType_t startTime = 0;
+    TickType_t lastCorrection = 0;
+    const TickType_t controlPeriod = pdMS_TO_TICKS(CONTROL_PERIOD_MS);
+    uint8_t stalledPeriods = 0;
+    bool isCorrectionSaturated = false;
 
-    Motion::left.setSpeed(LEFT_MOTOR_DUTY);
-    Motion::right.setSpeed(RIGHT_MOTOR_DUTY);
-    Motion::xLastWakeTime = xTaskGetTickCount();
     while(1){
-        if(runtime>40||runtime==0){
-            vTaskDelayUntil(&xLastWakeTime,40);
-            runtime -= 40;
-            //calc new parameters
-            //set new parameters
-            int fifocount = detection.getDataFromFIFO(buffer);
-            int rightCounter = 0;
-            int leftCounter = 0;
-            int changerate = 0;
-            for(int i = 0;i<fifocount;i++){
-                if(buffer[i].gyro.z>correctionThreshold){
-                    rightCounter++;
-                } else if(buffer[i].gyro.z<-correctionThreshold){
-                    leftCounter++;
-                }
+        //continue the ramps of the motors in short steps, see Motor::update()
+        Motion::left.update();
+        Motion::right.update();
+
+        //sleep until the next command, correction, end of the current command or step of a ramp
+        TickType_t timeout = portMAX_DELAY;
+        if(isActive){
+            TickType_t now = xTaskGetTickCount();
+            timeout = controlPeriod - std::min(now - lastCorrection, controlPeriod);
+            if(current.durationMs > 0){
+                TickType_t elapsed = now - startTime;
+                TickType_t duration = pdMS_TO_TICKS(current.durationMs);
+                timeout = std::min(timeout, duration - std::min(elapsed, duration));
             }
-            int difference = abs(leftCounter-rightCounter);
-            if (difference>25){
-                changerate = 200;
-            } else if(difference>20){
-                changerate = 100;
-            } else if(difference >15){
-                changerate = 50;
-            } else if(difference > 10){
-                changerate = 20;
-            } else{
-                changerate = 5; 
+        }
+        if(Motion::left.isRamping() || Motion::right.isRamping()){
+            timeout = std::min(timeout, pdMS_TO_TICKS(MOTOR_RAMP_STEP_MS));
+        }
+
+        if(xQueueReceive(commandQueue, &command, timeout) == pdTRUE){
+            MotionTelemetry telemetry;
+            if(isActive){
+                publishTelemetry(current, lastCorrection, telemetry);
+                finishCommand(current, MOTION_PREEMPTED);
+            } else {
+                //discard stale packages, so the first period only sees this command
+                detection.getDataFromFIFO(buffer);
             }
+            current = command;
+            startTime = xTaskGetTickCount();
+            lastCorrection = startTime;
+            stalledPeriods = 0;
+            isCorrectionSaturated = false;
+            isActive = startCommand(current);
+            if(!isActive){
+                finishCommand(current, MOTION_COMPLETED);
+            }
+            continue;
+        }
+        if(!isActive){
+            continue;
+        }
 
-            if(leftCounter>rightCounter){ //rotates anticlock
-                LEFT_MOTOR_DUTY+=changerate;
-                RIGHT_MOTOR_DUTY-=changerate;
-            } else if(leftCounter<rightCounter){
-                LEFT_MOTOR_DUTY-=changerate;
-                RIGHT_MOTOR_DUTY+=changerate;
-            } 
-
-            Motion::left.setSpeed(LEFT_MOTOR_DUTY);
-            Motion::right.setSpeed(RIGHT_MOTOR_DUTY);
-        } else {
-            vTaskDelayUntil(&xLastWakeTime,runtime);
+        TickType_t now = xTaskGetTickCount();
+        MotionTelemetry telemetry;
+        if(current.durationMs > 0 && now - startTime >= pdMS_TO_TICKS(current.durationMs)){
+            publishTelemetry(current, lastCorrection, telemetry);
             Motion::left.setSpeed(0);
             Motion::right.setSpeed(0);
-            vTaskDelete(xMoveTaskHandle);
+            isActive = false;
+            finishCommand(current, MOTION_COMPLETED);
+        } else if(now - lastCorrection >= controlPeriod){
+            bool hasData = publishTelemetry(current, lastCorrection, telemetry);
+            lastCorrection = now;
+            if(!hasData){
+                continue;
+            }
+            if(isStalled(current, (now - startTime)*portTICK_PERIOD_MS, telemetry, isCorrectionSaturated, stalledPeriods)){
+                LEFT_MOTOR_DUTY = 0;
+                RIGHT_MOTOR_DUTY = 0;
+                Motion::left.setSpeed(0);
+                Motion::right.setSpeed(0);
+                isActive = false;
+                finishCommand(current, MOTION_STALLED);
+            } else if(current.type == MOTION_MOVE){
+                isCorrectionSaturated = correctMovement(telemetry.yawRate);
+            }
         }
     }
 };
 
-// Move forward for a certain amount of time.
-void Motion::move(uint32_t moveForMs, uint baseValue) {    
-       if(xMoveTaskHandle){
-            vTaskDelete(xMoveTaskHandle);
-            xMoveTaskHandle = NULL;
-       }
-       if(xClockwiseTaskHandle){
-
-            vTaskDelete(xClockwiseTaskHandle);
-            xClockwiseTaskHandle = NULL;
-       }
-       if(xAntiClockwiseTaskHandle){
-            vTaskDelete(xAntiClockwiseTaskHandle);
-            xAntiClockwiseTaskHandle = NULL;
-
-       }
-       LEFT_MOTOR_DUTY = baseValue;
-       RIGHT_MOTOR_DUTY = baseValue;
-        xTaskCreate(moveTask, "Move", 4096, (void*)moveForMs, 10, &xMoveTaskHandle);
-        
-};
-
-void Motion::leftMotorTask(void * args) {
-     uint32_t runtime = (uint32_t)args;
-     if(xMoveTaskHandle){
-        vTaskDelete(xMoveTaskHandle);
-        xMoveTaskHandle = NULL;
+bool Motion::startCommand(const MotionCommand &command) {
+    switch(command.type){
+        case MOTION_MOVE:
+            BASE_DUTY = command.leftDuty;
+            LEFT_MOTOR_DUTY = command.leftDuty;
+            RIGHT_MOTOR_DUTY = command.rightDuty;
+            straightController.reset();
+            break;
+        case MOTION_ROTATE_CLOCKWISE:
+            LEFT_MOTOR_DUTY = command.leftDuty;
+            RIGHT_MOTOR_DUTY = 0;
+            break;
+        case MOTION_ROTATE_ANTICLOCKWISE:
+            LEFT_MOTOR_DUTY = 0;
+            RIGHT_MOTOR_DUTY = command.rightDuty;
+            break;
+        case MOTION_SET_DUTY:
+            LEFT_MOTOR_DUTY = command.leftDuty;
+            RIGHT_MOTOR_DUTY = command.rightDuty;
+            break;
+        case MOTION_STOP:
+            LEFT_MOTOR_DUTY = 0;
+            RIGHT_MOTOR_DUTY = 0;
+            break;
     }
-    if(xAntiClockwiseTaskHandle){
-        vTaskDelete(xAntiClockwiseTaskHandle);
-        xAntiClockwiseTaskHandle = NULL;
-    }
-    Motion::right.setSpeed(0);
     Motion::left.setSpeed(LEFT_MOTOR_DUTY);
-    while(1){
-        if((runtime>40)||(runtime==0)){
-            vTaskDelayUntil(&xLastWakeTime,40);
-            runtime -=40;
-        } else {
-            vTaskDelayUntil(&xLastWakeTime,runtime);
-            Motion::left.setSpeed(0);
-            vTaskDelete(xClockwiseTaskHandle);
-        }
-        vTaskDelayUntil(&xLastWakeTime,40);
+    Motion::right.setSpeed(RIGHT_MOTOR_DUTY);
+    return command.type != MOTION_STOP;
+};
+
+bool Motion::correctMovement(float yawRate) {
+    //a negative yaw rate means the robot rotates anticlock, so the left motor needs more power
+    float correction = straightController.update(-yawRate, CONTROL_PERIOD_MS/1000.0);
+    LEFT_MOTOR_DUTY = constrain(BASE_DUTY + correction, 0, MAX_DUTY);
+    RIGHT_MOTOR_DUTY = constrain(BASE_DUTY - correction, 0, MAX_DUTY);
+    Motion::left.setSpeed(LEFT_MOTOR_DUTY);
+    Motion::right.setSpeed(RIGHT_MOTOR_DUTY);
+    PIDConfig config = straightController.getConfig();
+    return correction <= config.outputMin || correction >= config.outputMax;
+};
+
+bool Motion::publishTelemetry(const MotionCommand &command, TickType_t periodStart, MotionTelemetry &telemetry) {
+    int fifocount = detection.getDataFromFIFO(buffer);
+    bool hasData = fifocount > 0;
+    telemetry = {
+        .timestamp = millis(),
+        .dt = (xTaskGetTickCount() - periodStart)*portTICK_PERIOD_MS/1000.0f,
+        .type = command.type,
+        .leftDuty = LEFT_MOTOR_DUTY,
+        .rightDuty = RIGHT_MOTOR_DUTY,
+        .hasYawRate = hasData,
+        .yawRate = hasData ? meanYawRate(fifocount) : 0,
+        .vibration = hasData ? vibrationLevel(fifocount) : 0
+    };
+    if(telemetryObserver){
+        telemetryObserver(telemetry, telemetryContext);
     }
+    return hasData;
 };
 
-// Rotate clockwise for a certain amount of time.
-void Motion::rotateClockwise(uint32_t rotateForMs,uint baseValue) {
-    LEFT_MOTOR_DUTY = baseValue;
-    RIGHT_MOTOR_DUTY = baseValue;
-    if (rotateForMs > 0){
-        if(xClockwiseTaskHandle){
-            vTaskDelete(xClockwiseTaskHandle);
-        }
-        xTaskCreate(leftMotorTask, "LeftMotor", 4096, (void*)rotateForMs, 10, &xClockwiseTaskHandle);
+bool Motion::isStalled(const MotionCommand &command, uint32_t elapsedMs, const MotionTelemetry &telemetry, bool isCorrectionSaturated, uint8_t &stalledPeriods) {
+    bool isForward = command.type == MOTION_MOVE || (command.type == MOTION_SET_DUTY && command.leftDuty > 0 && command.rightDuty > 0);
+    if(!isStallDetectionEnabled || !isForward || elapsedMs < STALL_GRACE_MS){
+        stalledPeriods = 0;
+        return false;
+    }
+    bool isNotShaking = telemetry.vibration < stallVibration;
+    bool isPushedAside = isCorrectionSaturated && abs(telemetry.yawRate) > STALL_YAW_RATE;
+    if(isNotShaking || isPushedAside){
+        stalledPeriods++;
     } else {
-        Motion::left.setSpeed(LEFT_MOTOR_DUTY);
-        Motion::right.setSpeed(0);
+        stalledPeriods = 0;
     }
+    return stalledPeriods >= STALL_PERIODS;
 };
 
-void Motion::rightMotorTask(void * args) {
-    uint32_t runtime = (uint32_t)args;
-     if(xMoveTaskHandle){
-        vTaskDelete(xMoveTaskHandle);
-        xMoveTaskHandle = NULL;
+void Motion::finishCommand(const MotionCommand &command, MotionResult result) {
+    if(command.notifyTask){
+        //the sequence lets waitForCompletion ignore notifications of older commands
+        xTaskNotify(command.notifyTask, (command.sequence << 8) | result, eSetValueWithOverwrite);
     }
-    if(xClockwiseTaskHandle){
-        vTaskDelete(xClockwiseTaskHandle);
-        xClockwiseTaskHandle = NULL;
-    }
-    Motion::right.setSpeed(RIGHT_MOTOR_DUTY);
-    Motion::left.setSpeed(0);
-    while(1){
-        if(runtime>40||runtime==0){
-            vTaskDelayUntil(&xLastWakeTime,40);
-            runtime -= 40;
-        } else {
-            vTaskDelayUntil(&xLastWakeTime,runtime);
-            Motion::right.setSpeed(0);
-            vTaskDelete(xAntiClockwiseTaskHandle);
-        }
+};
+
+uint32_t Motion::sendCommand(MotionCommandType type, uint32_t durationMs, uint16_t leftDuty, uint16_t rightDuty) {
+    if(!commandQueue){
+        //begin() was not called yet
+        return 0;
     }
+    //several tasks may issue commands concurrently
+    const uint32_t sequence = (lastSequence.fetch_add(1) + 1) & MOTION_SEQUENCE_MASK;
+    MotionCommand command = {
+        .type = type,
+        .durationMs = durationMs,
+        .leftDuty = leftDuty,
+        .rightDuty = rightDuty,
+        .timestamp = xTaskGetTickCount(),
+        .sequence = sequence,
+        .notifyTask = xTaskGetCurrentTaskHandle()
+    };
+    xQueueSend(commandQueue, &command, portMAX_DELAY);
+    return sequence;
 };
 
-// Rotate anticlockwise for a certain amount of time.
-void Motion::rotateAntiClockwise(uint32_t rotateForMs,uint baseValue) {
-    LEFT_MOTOR_DUTY = baseValue;
-    RIGHT_MOTOR_DUTY = baseValue;
-    if(rotateForMs > 0){
-        if(xAntiClockwiseTaskHandle){
-            vTaskDelete(xAntiClockwiseTaskHandle);
-        }
-        xTaskCreate(rightMotorTask, "RightMotor", 4096, (void*)rotateForMs, 10, &xAntiClockwiseTaskHandle);
-    } else {
-        Motion::right.setSpeed(RIGHT_MOTOR_DUTY);
-        Motion::left.setSpeed(0);
+float Motion::meanYawRate(int fifocount){
+    int32_t cumulatedRate = 0;
+    for(int i = 0;i<fifocount;i++){
+        cumulatedRate += buffer[i].gyro.z;
     }
+    return cumulatedRate/(fifocount*GYRO_LSB_PER_DPS);
 };
 
-void Motion::stop(void){
-    if(xMoveTaskHandle){
-        vTaskDelete(xMoveTaskHandle);
-        xMoveTaskHandle = NULL;
+float Motion::vibrationLevel(int fifocount){
+    int64_t sum[3] = {0, 0, 0};
+    int64_t squaredSum[3] = {0, 0, 0};
+    for(int i = 0;i<fifocount;i++){
+        int32_t values[3] = {buffer[i].accel.x, buffer[i].accel.y, buffer[i].accel.z};
+        for(int axis = 0;axis<3;axis++){
+            sum[axis] += values[axis];
+            squaredSum[axis] += values[axis]*values[axis];
+        }
     }
-    if(xAntiClockwiseTaskHandle){
-        vTaskDelete(xAntiClockwiseTaskHandle);
-        xAntiClockwiseTaskHandle = NULL;
+    //the variances of all axes add up to the variance of the acceleration vector
+    float variance = 0;
+    for(int axis = 0;axis<3;axis++){
+        float mean = (float)sum[axis]/fifocount;
+        variance += (float)squaredSum[axis]/fifocount - mean*mean;
     }
-    if(xClockwiseTaskHandle){
-        vTaskDelete(xClockwiseTaskHandle);
-        xClockwiseTaskHandle = NULL;
+    return sqrt(std::max(variance, 0.0f))/ACCEL_LSB_PER_G;
+};
+
+// Move forward for a certain amount of time.
+uint32_t Motion::move(uint32_t moveForMs, uint baseValue) {
+    return sendCommand(MOTION_MOVE, moveForMs, baseValue, baseValue);
+};
+
+void Motion::setBaseValue(uint baseValue) {
+    BASE_DUTY = std::min(baseValue, (uint) MAX_DUTY);
+};
+
+// Rotate clockwise for a certain amount of time.
+uint32_t Motion::rotateClockwise(uint32_t rotateForMs,uint baseValue) {
+    return sendCommand(MOTION_ROTATE_CLOCKWISE, rotateForMs, baseValue, baseValue);
+};
+
+// Rotate anticlockwise for a certain amount of time.
+uint32_t Motion::rotateAntiClockwise(uint32_t rotateForMs,uint baseValue) {
+    return sendCommand(MOTION_ROTATE_ANTICLOCKWISE, rotateForMs, baseValue, baseValue);
+};
+
+uint32_t Motion::stop(void){
+    return sendCommand(MOTION_STOP, 0, 0, 0);
+};
+
+uint32_t Motion::moveWithoutCorrection(uint32_t moveForMs, uint baseValue){
+    return sendCommand(MOTION_SET_DUTY, moveForMs, baseValue, baseValue);
+};
+
+uint32_t Motion::setDuty(uint16_t leftDuty, uint16_t rightDuty, uint32_t forMs){
+    return sendCommand(MOTION_SET_DUTY, forMs, leftDuty, rightDuty);
+};
+
+void Motion::setStallDetection(bool enabled, float vibration){
+    stallVibration = vibration;
+    isStallDetectionEnabled = enabled;
+};
+
+void Motion::onTelemetry(MotionTelemetryObserver observer, void *context){
+    //set the context first, so the motor task never calls a new observer with an old context
+    telemetryObserver = NULL;
+    telemetryContext = context;
+    telemetryObserver = observer;
+};
+
+MotionResult Motion::waitForCompletion(uint32_t sequence, uint32_t timeoutMs){
+    TickType_t timeout = timeoutMs == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    TickType_t start = xTaskGetTickCount();
+    uint32_t notification;
+    while(1){
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t remaining = timeout == portMAX_DELAY ? portMAX_DELAY : timeout - std::min(elapsed, timeout);
+        if(xTaskNotifyWait(0, ULONG_MAX, &notification, remaining) != pdTRUE){
+            return MOTION_TIMEOUT;
+        }
+        const uint32_t notifiedSequence = notification >> 8;
+        if(notifiedSequence == sequence){
+            return (MotionResult)(notification & 0xFF);
+        }
+        //the commands of a task complete in order, so a newer notification overwrote the one of the awaited command
+        const uint32_t distance = (notifiedSequence - sequence) & MOTION_SEQUENCE_MASK;
+        if(distance < MOTION_SEQUENCE_MASK / 2){
+            return MOTION_PREEMPTED;
+        }
     }
-    Motion::left.setSpeed(0);
-    Motion::right.setSpeed(0);
-}
- 
+};
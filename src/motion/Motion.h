@@ -12,11 +12,15 @@
 #ifndef Motion_h
 #define Motion_h
 #include <stdint.h>
+#include <algorithm>
+#include <atomic>
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include "driver/ledc.h"
 #include "motionDetection/MotionDetection.h"
+#include "PIDController.h"
 #define LEDC_MODE          LEDC_LOW_SPEED_MODE
 #define TIMER              LEDC_TIMER_2
 #define CHANNEL_LEFT       LEDC_CHANNEL_3 
@@ -24,6 +28,34 @@
 #define DUTY_RES           LEDC_TIMER_13_BIT // Set duty resolution to 13 bits
 #define FREQUENCY          (5000) // Frequency in Hertz. Set frequency at 5 kHz
 #define DEFAULT_BASE_VALUE  3900
+#define MAX_DUTY           8191
+#define GYRO_LSB_PER_DPS   32.8f // sensitivity of the gyroscope at +-1000 dps
+#define ACCEL_LSB_PER_G    2048.0f // sensitivity of the accelerometer at +-16 g
+#define MOTOR_TASK_STACK_SIZE 4096
+#define MOTOR_TASK_PRIORITY   10
+#define MOTION_QUEUE_LENGTH   8
+#define CONTROL_PERIOD_MS     40 // after 40ms the FIFO of the IMU is full
+#define STALL_GRACE_MS        120 // time after starting a movement until the motors run at full speed
+#define STALL_PERIODS         2 // consecutive control periods that must indicate a stall
+#define DEFAULT_STALL_VIBRATION 0.05f // vibration in g below which the robot is considered stalled
+#define MOTION_SEQUENCE_MASK  0x00FFFFFF // the sequence shares the task notification value with the result
+#define MOTOR_RAMP_STEP_MS    10 // longest hardware fade, a new duty is applied after the running fade at the latest
+#define STALL_YAW_RATE        20.0f // yaw rate in degree per second the saturated straight controller cannot correct
+
+/**
+ * @brief Acceleration profile of a motor, i.e. how fast the duty may change.
+ * A rate of 0 sets the duty instantly.
+ * 
+ */
+struct MotorRamp{
+    uint16_t accelerationPerMs; // duty increase per ms
+    uint16_t decelerationPerMs; // duty decrease per ms
+};
+
+static const MotorRamp INSTANT_MOTOR_RAMP = {0, 0};
+static const MotorRamp DEFAULT_MOTOR_RAMP = {400, 800}; // full speed within ~20ms
+static const MotorRamp SOFT_MOTOR_RAMP = {100, 200};
+
 class Motor{
     public:
         Motor(uint8_t pin, ledc_timer_t timer, ledc_channel_t channel);
@@ -34,47 +66,213 @@ class Motor{
         void begin(void);
         
         /**
-         * @brief Set the Speed by changing the pwm. To avoid current peaks, a linear ramp-up is used.
+         * @brief Set the Speed by changing the pwm. To avoid current peaks, a linear ramp is used.
+         * The ramp is executed by the fade engine of the LEDC hardware in steps of at most MOTOR_RAMP_STEP_MS, see update().
+         * The method never waits for a running step, it only sets the new target then.
          * 
          * @attention it is requried at any time to use that method to access the motors or methods of the motionclass to avoid such peaks.
          * 
          * @param duty the duty cyle that should be set, can be between 0-8192
          */
         void setSpeed(uint16_t duty);
+
+        /**
+         * @brief Start the next step of the ramp towards the duty set by setSpeed(), if the previous step finished.
+         * The ESP-IDF 4.4 cannot retarget a running fade without blocking, so long ramps are split into short steps
+         * that are continued by the motor task.
+         */
+        void update(void);
+
+        /**
+         * @return true if the ramp has not reached the duty set by setSpeed() yet
+         */
+        bool isRamping(void);
         
         /**
-         * @brief returns the currently activ speed
+         * @brief returns the speed that was set last, the ramp towards it may still be running
          * 
          * @return current speedvalue of the motor
          */
         uint16_t getSpeed(void); 
+
+        /**
+         * @brief Set the acceleration profile that is used by setSpeed
+         * 
+         * @param ramp the profile, e.g. DEFAULT_MOTOR_RAMP, SOFT_MOTOR_RAMP or INSTANT_MOTOR_RAMP
+         */
+        void setRamp(MotorRamp ramp);
+
+        /**
+         * @brief returns the acceleration profile that is used by setSpeed
+         * 
+         * @return the current profile
+         */
+        MotorRamp getRamp(void);
     protected:
         uint8_t pin;
         ledc_timer_t timer;
         ledc_channel_t channel;
+        MotorRamp ramp = DEFAULT_MOTOR_RAMP;
        
         uint16_t duty;
+        uint16_t stepDuty; //duty at the end of the current step of the ramp
+        uint32_t stepEnd; //millis() at the end of the current step
+};
+
+/**
+ * @brief Commands that are processed by the motor task.
+ * 
+ */
+enum MotionCommandType{
+    MOTION_MOVE,
+    MOTION_ROTATE_CLOCKWISE,
+    MOTION_ROTATE_ANTICLOCKWISE,
+    MOTION_STOP,
+    MOTION_SET_DUTY
 };
 
+/**
+ * @brief Outcome of a command, passed to the issuing task on completion.
+ * 
+ */
+enum MotionResult{
+    MOTION_COMPLETED,   // duration elapsed or command has no duration
+    MOTION_PREEMPTED,   // replaced by a newer command before its duration elapsed
+    MOTION_TIMEOUT,     // waitForCompletion timed out
+    MOTION_STALLED      // aborted, as the motors were running but the robot did not move
+};
+
+struct MotionCommand{
+    MotionCommandType type;
+    uint32_t durationMs;    // 0 runs the command until the next one is issued
+    uint16_t leftDuty;
+    uint16_t rightDuty;
+    TickType_t timestamp;   // tick count when the command was issued
+    uint32_t sequence;      // consecutive number to match completion notifications
+    TaskHandle_t notifyTask;
+};
+
+/**
+ * @brief State of the motors during one control period, published by the motor task.
+ * 
+ */
+struct MotionTelemetry{
+    uint32_t timestamp;     // millis() at the end of the period
+    float dt;               // length of the period in seconds
+    MotionCommandType type; // command that was running during the period
+    uint16_t leftDuty;      // duty commanded to the left motor during the period
+    uint16_t rightDuty;     // duty commanded to the right motor during the period
+    bool hasYawRate;        // false if the IMU delivered no data
+    float yawRate;          // mean yaw rate in degree per second, positive values mean clockwise rotation
+    float vibration;        // standard deviation of the acceleration in g, caused by the vibration motors
+};
+
+/**
+ * @brief Callback that receives the telemetry of every control period.
+ * It runs in the motor task, so it must return quickly and must not issue motion commands.
+ */
+typedef void (*MotionTelemetryObserver)(const MotionTelemetry &telemetry, void *context);
+
 class Motion{
 protected:
     static inline uint16_t RIGHT_MOTOR_DUTY = DEFAULT_BASE_VALUE;
     static inline uint16_t LEFT_MOTOR_DUTY = DEFAULT_BASE_VALUE;
     static const int MOTOR_RIGHT_PIN = 11; 
     static const int MOTOR_LEFT_PIN = 12;
-    static void moveTask(void * args);
-    static void leftMotorTask(void * args);
-    static void rightMotorTask(void * args);
-    static inline TaskHandle_t xMoveTaskHandle = NULL;
-    static inline TaskHandle_t xClockwiseTaskHandle = NULL;
-    static inline TaskHandle_t xAntiClockwiseTaskHandle = NULL;
-    static inline TickType_t xLastWakeTime;
+    static inline volatile uint16_t BASE_DUTY = DEFAULT_BASE_VALUE; //written by setBaseValue() while the motor task runs
 
     static inline FIFO_Package* buffer = new FIFO_Package[64];
-    static inline int correctionThreshold = 150; 
+
+    //the motor task and its queue are allocated statically and live as long as the program
+    static inline StackType_t motorTaskStack[MOTOR_TASK_STACK_SIZE];
+    static inline StaticTask_t motorTaskBuffer;
+    static inline TaskHandle_t xMotorTaskHandle = NULL;
+    static inline uint8_t commandQueueStorage[MOTION_QUEUE_LENGTH*sizeof(MotionCommand)];
+    static inline StaticQueue_t commandQueueBuffer;
+    static inline QueueHandle_t commandQueue = NULL;
+    static inline std::atomic<uint32_t> lastSequence{0};
+
+    static inline MotionTelemetryObserver telemetryObserver = NULL;
+    static inline void *telemetryContext = NULL;
+
+    /**
+     * @brief The only task that accesses the motors. Waits for commands from the queue,
+     * ends timed commands and runs the straight movement correction every CONTROL_PERIOD_MS.
+     */
+    static void motorTask(void * args);
+
+    /**
+     * @brief Set the motor duties for a newly received command.
+     * 
+     * @return true if the command runs until its duration elapses or another command is received, false if it completed immediately
+     */
+    static bool startCommand(const MotionCommand &command);
+
+    static inline bool isStallDetectionEnabled = true;
+    static inline float stallVibration = DEFAULT_STALL_VIBRATION;
+
+    /**
+     * @brief Apply the straight movement correction of a running move command.
+     * 
+     * @param yawRate measured yaw rate in degree per second
+     * @return true if the correction is at the limit of the straightController
+     */
+    static bool correctMovement(float yawRate);
+
+    /**
+     * @brief Read the FIFO of the IMU and pass the period that ends now to the telemetry observer.
+     * 
+     * @param command the command that was running during the period
+     * @param periodStart tick count at the start of the period
+     * @param telemetry set to the telemetry of the period
+     * @return true if the IMU delivered data, i.e. yaw rate and vibration are valid
+     */
+    static bool publishTelemetry(const MotionCommand &command, TickType_t periodStart, MotionTelemetry &telemetry);
+
+    /**
+     * @brief Check if the motors are running forward but the robot does not move, e.g. because it is pushing against an obstacle.
+     * This is the case if the motors barely shake the robot or if the robot keeps rotating although the straightController is at its limit.
+     * 
+     * @param command the running command
+     * @param elapsedMs time since the command was started
+     * @param telemetry telemetry of the last period
+     * @param isCorrectionSaturated true if the straightController is at its limit
+     * @param stalledPeriods number of consecutive periods indicating a stall, updated by the function
+     * @return true if STALL_PERIODS consecutive periods indicated a stall
+     */
+    static bool isStalled(const MotionCommand &command, uint32_t elapsedMs, const MotionTelemetry &telemetry, bool isCorrectionSaturated, uint8_t &stalledPeriods);
+
+    /**
+     * @brief Notify the issuing task about the completion of a command.
+     */
+    static void finishCommand(const MotionCommand &command, MotionResult result);
+
+    /**
+     * @brief Put a command into the queue of the motor task.
+     * 
+     * @return the sequence of the command, see waitForCompletion()
+     */
+    static uint32_t sendCommand(MotionCommandType type, uint32_t durationMs, uint16_t leftDuty, uint16_t rightDuty);
+
+    /**
+     * @brief Calculates the mean yaw rate of the fetched FIFO packages.
+     * 
+     * @param fifocount amount of packages in buffer
+     * @return the yaw rate in degree per second, positive values mean clockwise rotation
+     */
+    static float meanYawRate(int fifocount);
+
+    /**
+     * @brief Calculates the vibration of the fetched FIFO packages, i.e. the standard deviation of the acceleration.
+     * 
+     * @param fifocount amount of packages in buffer
+     * @return the vibration in g
+     */
+    static float vibrationLevel(int fifocount);
 
 public:
     //Instances of the motors, so they can also be used from outside to set values for the motors directly.
+    //Prefer setDuty(), direct access races with the motor task if a command is running.
     static inline Motor left = Motor(MOTOR_LEFT_PIN,TIMER,CHANNEL_LEFT);
     static inline Motor right = Motor(MOTOR_RIGHT_PIN,TIMER,CHANNEL_RIGHT);
     
@@ -82,7 +280,21 @@ public:
     static inline MotionDetection detection;
 
     /**
-     * @brief Initialize the movement component.
+     * @brief Controller that keeps the robot driving straight in move().
+     * The error is the measured yaw rate in degree per second, the output is the duty that is added to the left and subtracted from the right motor.
+     * Gains can be changed with setConfig(), an observer to record the step response can be registered with onUpdate().
+     */
+    static inline PIDController straightController = PIDController({
+        .kp = 30,
+        .ki = 150,
+        .kd = 0.5,
+        .outputMin = -1500,
+        .outputMax = 1500,
+        .integralLimit = 1200
+    });
+
+    /**
+     * @brief Initialize the movement component and start the motor task.
      * 
     */
     void begin(void);
@@ -90,44 +302,101 @@ public:
     /**
      * @brief Move forward for a certain amount of time.
      * Call with moveForMs 0 will start movement, that must be stopped explicit by call to stop().
-     * The function applys a basic algorithm to improve the straigthness of the movement. 
+     * The function uses the straightController to keep the measured yaw rate at zero, which improves the straigthness of the movement.
      * Lifting the robot from the desk may corrupt the results and is not recommended.
      *  
      * @param moveForMs Representing the duration of forward moving in milliseconds.
      * @param baseValue The value that is used to start with the calibrated movement. Defaults to 3900. 
      * If the Dezibot is not moving forward at all increasing the value may help. If the robot is just jumping up and down but not forward, try a lower value. 
+     * @return the sequence of the command, pass it to waitForCompletion()
     */
-    static void move(uint32_t moveForMs=0,uint baseValue=DEFAULT_BASE_VALUE);
+    static uint32_t move(uint32_t moveForMs=0,uint baseValue=DEFAULT_BASE_VALUE);
+
+    /**
+     * @brief Change the base value of a running move() without restarting it, e.g. to follow a speed profile.
+     * The straightController keeps its state and the motors fade to the new duty. Has no effect on other commands.
+     * 
+     * @param baseValue the new base value, can be between 0-8191
+     */
+    static void setBaseValue(uint baseValue);
 
     /**
      * @brief Rotate clockwise for a certain amount of time.
+     * Only the left motor runs, so the robot pivots around its right wheel. Each motor is driven by a single pwm pin
+     * without h-bridge, hence it cannot run in reverse to rotate in place.
      * Call with moveForMs 0 will start movement, that must be stopped explicit by call to stop().
      * @param rotateForMs Representing the duration of rotating clockwise in milliseconds, or 0 to rotate until another movecmd is issued. Default is 0
      * @param baseValue The value that is used to start with the calibrated movement (not released yet, currently just the used value)
+     * @return the sequence of the command, pass it to waitForCompletion()
     */
-    static void rotateClockwise(uint32_t rotateForMs=0,uint baseValue=DEFAULT_BASE_VALUE);
+    static uint32_t rotateClockwise(uint32_t rotateForMs=0,uint baseValue=DEFAULT_BASE_VALUE);
     
     /**
      * @brief Rotate anticlockwise for a certain amount of time.
+     * Only the right motor runs, so the robot pivots around its left wheel, see rotateClockwise().
      * Call with moveForMs 0 will start movement, that must be stopped explicit by call to stop().
      * @param rotateForMs Representing the duration of rotating anticlockwise in milliseconds or 0 to let the robot turn until another movecommand is issued. Default is 0.
      * @param baseValue The value that is used to start with the calibrated movement (not released yet, currently just the used value).
+     * @return the sequence of the command, pass it to waitForCompletion()
     */
-    static void rotateAntiClockwise(uint32_t rotateForMs=0,uint baseValue=DEFAULT_BASE_VALUE);
+    static uint32_t rotateAntiClockwise(uint32_t rotateForMs=0,uint baseValue=DEFAULT_BASE_VALUE);
 
     /**
      * @brief stops any current movement, no matter if timebased or endless
      * 
+     * @return the sequence of the command, pass it to waitForCompletion()
      */
-    static void stop(void);
+    static uint32_t stop(void);
 
     /**
      * @brief Does the same as the move function, but this function does not apply any kind of algorithm to improve the result.
      * 
      * @param moveForMs how many ms should the robot move, or 0 to let the robot move until another move command is mentioned, default is 0
      * @param baseValue the duty value that is used for the movement, default is 0
+     * @return the sequence of the command, pass it to waitForCompletion()
+     */
+    static uint32_t moveWithoutCorrection(uint32_t moveForMs=0, uint baseValue = DEFAULT_BASE_VALUE);
+
+    /**
+     * @brief Set the duty of both motors, e.g. to drive a curve.
+     * 
+     * @param leftDuty duty of the left motor, can be between 0-8191
+     * @param rightDuty duty of the right motor, can be between 0-8191
+     * @param forMs how many ms the duties should be kept, or 0 to keep them until another move command is issued, default is 0
+     * @return the sequence of the command, pass it to waitForCompletion()
+     */
+    static uint32_t setDuty(uint16_t leftDuty, uint16_t rightDuty, uint32_t forMs=0);
+
+    /**
+     * @brief Configure the stall detection of move() and of setDuty() with both motors running.
+     * If the robot is stalled, the command is aborted within about STALL_PERIODS control periods and waitForCompletion() returns MOTION_STALLED.
+     * 
+     * @param enabled false to disable the stall detection, default is enabled
+     * @param vibration vibration in g below which the robot is considered stalled, depends on the surface, see MotionTelemetry::vibration
+     */
+    static void setStallDetection(bool enabled, float vibration=DEFAULT_STALL_VIBRATION);
+
+    /**
+     * @brief Register an observer that receives the duties and the measured yaw rate of every control period while a command is running,
+     * e.g. to track the position of the robot. Only one observer is supported.
+     * 
+     * @param observer callback, or NULL to remove the current observer
+     * @param context pointer that is passed to the callback unchanged
+     */
+    static void onTelemetry(MotionTelemetryObserver observer, void *context=NULL);
+
+    /**
+     * @brief Block the calling task until a command it issued is completed.
+     * All commands are processed asynchronously by the motor task, so e.g. move(1000) returns immediately.
+     * 
+     * @attention Uses the FreeRTOS task notification of the calling task. Only the latest notification is kept,
+     * so if the task issued further commands in the meantime, the result of an older command may be lost. It is reported as MOTION_PREEMPTED then.
+     * 
+     * @param sequence the sequence returned by the command, e.g. by move()
+     * @param timeoutMs maximum time to wait in ms, default is to wait forever
+     * @return MOTION_COMPLETED if the duration of the command elapsed, MOTION_PREEMPTED if it was replaced by another command, MOTION_STALLED if it was aborted by the stall detection, MOTION_TIMEOUT otherwise
      */
-    static void moveWithoutCorrection(uint32_t moveForMs=0, uint baseValue = DEFAULT_BASE_VALUE);
+    static MotionResult waitForCompletion(uint32_t sequence, uint32_t timeoutMs=portMAX_DELAY);
 
 };
 
@@ -5,6 +5,8 @@ Motor::Motor(uint8_t pin, ledc_timer_t timer, ledc_channel_t channel){
     this->channel = channel;
     this->timer = timer;
     this->duty = 0;
+    this->stepDuty = 0;
+    this->stepEnd = 0;
 };
 
 void Motor::begin(void){
@@ -23,26 +25,46 @@ void Motor::begin(void){
 };
 
 void Motor::setSpeed(uint16_t duty){
-    
-    int difference = duty-this->getSpeed();
-    if (difference > 0){
-        for(int i = 0;i<difference;i+=difference/20){
-            this->duty += difference/20;
-            ledc_set_duty(LEDC_MODE,this->channel,duty);
-            ledc_update_duty(LEDC_MODE,this->channel);
-            delayMicroseconds(5);
-        }
-    } else {
-        for(int i = 0;i>difference;i-=abs(difference/20)){
-            this->duty -= abs(difference/20);
-            ledc_set_duty(LEDC_MODE,this->channel,duty);
-            ledc_update_duty(LEDC_MODE,this->channel);
-            delayMicroseconds(5);
-        }
+    this->duty = duty;
+    this->update();
+};
+
+void Motor::update(void){
+    int difference = this->duty-this->stepDuty;
+    if (difference == 0 || (int32_t)(millis()-this->stepEnd) < 0){
+        //a running fade cannot be retargeted without waiting for it
+        return;
+    }
+    uint16_t rate = difference > 0 ? this->ramp.accelerationPerMs : this->ramp.decelerationPerMs;
+    if (rate == 0){
+        ledc_set_duty_and_update(LEDC_MODE,this->channel,this->duty,0);
+        this->stepDuty = this->duty;
+        return;
     }
+    int step = constrain(difference, -(int)rate*MOTOR_RAMP_STEP_MS, (int)rate*MOTOR_RAMP_STEP_MS);
+    int fadeTime = abs(step)/rate;
+    this->stepDuty += step;
+    this->stepEnd = millis()+fadeTime;
+    if (fadeTime == 0){
+        ledc_set_duty_and_update(LEDC_MODE,this->channel,this->stepDuty,0);
+        return;
+    }
+    ledc_set_fade_with_time(LEDC_MODE,this->channel,this->stepDuty,fadeTime);
+    ledc_fade_start(LEDC_MODE,this->channel,LEDC_FADE_NO_WAIT);
+};
 
+bool Motor::isRamping(void){
+    return this->stepDuty != this->duty;
 };
 
 uint16_t Motor::getSpeed(void){
     return this->duty;
 };
+
+void Motor::setRamp(MotorRamp ramp){
+    this->ramp = ramp;
+};
+
+MotorRamp Motor::getRamp(void){
+    return this->ramp;
+};
@@ -0,0 +1,59 @@
+#include "PIDController.h"
+
+PIDController::PIDController(PIDConfig config){
+    this->config = config;
+};
+
+float PIDController::update(float error, float dt){
+    float proportional = config.kp * error;
+    float derivative = 0;
+    if (hasLastError && dt > 0){
+        derivative = config.kd * (error - lastError) / dt;
+    }
+    lastError = error;
+    hasLastError = true;
+
+    //integral is kept in output units, so changing ki does not make the output jump
+    float candidate = integral + config.ki * error * dt;
+    candidate = constrain(candidate, -config.integralLimit, config.integralLimit);
+    float output = proportional + candidate + derivative;
+
+    //conditional integration: only integrate if that does not drive the output further into saturation
+    bool saturatedHigh = output > config.outputMax && error > 0;
+    bool saturatedLow = output < config.outputMin && error < 0;
+    if (!saturatedHigh && !saturatedLow){
+        integral = candidate;
+    }
+    output = constrain(proportional + integral + derivative, config.outputMin, config.outputMax);
+
+    if (observer){
+        observer(PIDSample{
+            .timestamp = millis(),
+            .error = error,
+            .proportional = proportional,
+            .integral = integral,
+            .derivative = derivative,
+            .output = output
+        });
+    }
+    return output;
+};
+
+void PIDController::reset(void){
+    integral = 0;
+    lastError = 0;
+    hasLastError = false;
+};
+
+void PIDController::setConfig(PIDConfig config){
+    this->config = config;
+    integral = constrain(integral, -config.integralLimit, config.integralLimit);
+};
+
+PIDConfig PIDController::getConfig(void){
+    return config;
+};
+
+void PIDController::onUpdate(PIDObserver observer){
+    this->observer = observer;
+};
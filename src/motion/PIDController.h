@@ -0,0 +1,103 @@
+/**
+ * @file PIDController.h
+ * @author Ines Rohrbach, Nico Schramm
+ * @brief Reusable PID controller with anti-windup for the motion component.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef PIDController_h
+#define PIDController_h
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+ * @brief Gains and limits of a PID controller.
+ *
+ * The integral term is clamped to [-integralLimit, integralLimit] and the
+ * output to [outputMin, outputMax].
+ */
+struct PIDConfig {
+    float kp;
+    float ki;
+    float kd;
+    float outputMin;
+    float outputMax;
+    float integralLimit;
+};
+
+/**
+ * @brief Snapshot of one controller update, passed to the observer.
+ *
+ * Can be used to plot step responses, e.g. by printing every sample to Serial.
+ */
+struct PIDSample {
+    uint32_t timestamp;
+    float error;
+    float proportional;
+    float integral;
+    float derivative;
+    float output;
+};
+
+/**
+ * @brief Callback that is invoked after every update of the controller.
+ */
+typedef void (*PIDObserver)(const PIDSample &sample);
+
+class PIDController {
+public:
+    PIDController(PIDConfig config);
+
+    /**
+     * @brief Compute a new controller output.
+     *
+     * The integral is only accumulated while the output is not saturated in
+     * the direction of the error (conditional integration), so the controller
+     * does not wind up while the actuator is at its limit.
+     *
+     * @param error difference between setpoint and measured value
+     * @param dt time since the last update in seconds, must be greater than 0
+     * @return float the clamped controller output
+     */
+    float update(float error, float dt);
+
+    /**
+     * @brief Clear integral and derivative state, e.g. before a new manoeuvre.
+     *
+     */
+    void reset(void);
+
+    /**
+     * @brief Replace gains and limits. The controller state is kept.
+     *
+     * @param config new configuration
+     */
+    void setConfig(PIDConfig config);
+
+    /**
+     * @brief Get the currently used gains and limits.
+     *
+     * @return PIDConfig current configuration
+     */
+    PIDConfig getConfig(void);
+
+    /**
+     * @brief Register an observer that receives a sample after every update.
+     *
+     * @param observer callback, or NULL to remove the current observer
+     */
+    void onUpdate(PIDObserver observer);
+
+protected:
+    PIDConfig config;
+    PIDObserver observer = NULL;
+    float integral = 0;
+    float lastError = 0;
+    bool hasLastError = false;
+};
+
+#endif //PIDController_h
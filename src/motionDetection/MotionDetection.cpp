@@ -249,9 +249,6 @@ uint MotionDetection::getDataFromFIFO(FIFO_Package* buffer){
     fifocount = (fifohigh<<8)|fifolow;
     //fifocount |= this->readRegister(FIFO_COUNTL);
     //fifocount = (this->readRegister(FIFO_COUNTH)<<8);
-    Serial.println(fifolow);
-    Serial.println(fifohigh);
-    Serial.println(fifocount);
     handler->beginTransaction(SPISettings(frequency,SPI_MSBFIRST,SPI_MODE0));
     digitalWrite(34,LOW);
     handler->transfer(cmdRead(FIFO_DATA));